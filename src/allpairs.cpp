@@ -0,0 +1,204 @@
+#include "allpairs.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+
+namespace {
+
+constexpr double infinity = std::numeric_limits<double>::infinity();
+// 64x64 doubles are 32 KiB, the three tiles of a min-plus product stay in L2
+constexpr int tileSize = 64;
+// a Dijkstra relaxation or heap operation costs about this many vectorised min-plus steps, both
+// measured on graphs of a few thousand vertices
+constexpr double dijkstraStepCost = 90;
+
+inline double weightOf(const Graph& graph, int edge) {
+    return graph.isWeighted() ? graph.weights[edge] : 1;
+}
+
+// row[j] = min(row[j], toK + through[j]) over [colBegin, colEnd). The rows are distinct, so
+// with __restrict the compiler vectorises it without a runtime overlap check
+inline void relaxRow(double* __restrict row, const double* __restrict through, double toK,
+                     int colBegin, int colEnd) {
+    // branch free so it compiles to vector adds and mins
+    for (int j = colBegin; j < colEnd; ++j) {
+        double candidate = toK + through[j];
+        row[j] = candidate < row[j] ? candidate : row[j];
+    }
+}
+
+// d[i][j] = min(d[i][j], d[i][k] + d[k][j]) for i in [rowBegin, rowEnd), j in [colBegin, colEnd)
+// and k in [kBegin, kEnd). k is the outer loop, which keeps it right when the tile being
+// updated is also the one read from, as it is for the diagonal, row and column tiles.
+void relaxTile(double* d, size_t stride, int rowBegin, int rowEnd, int colBegin, int colEnd,
+               int kBegin, int kEnd) {
+    for (int k = kBegin; k < kEnd; ++k) {
+        const double* through = d + k * stride;
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            double* row = d + i * stride;
+            const double toK = row[k];
+            if (toK == infinity) continue;
+            if (i != k) {
+                relaxRow(row, through, toK, colBegin, colEnd);
+                continue;
+            }
+            // row k relaxed through itself, a no-op unless d[k][k] < 0 (a negative cycle)
+            if (toK < 0)
+                for (int j = colBegin; j < colEnd; ++j) row[j] = std::min(row[j], toK + row[j]);
+        }
+    }
+}
+
+void floydWarshall(const Graph& graph, DistanceMatrix& matrix, int threadCount) {
+    const int n = matrix.vertexCount;
+    const size_t stride = n;
+    double* d = matrix.distances.data();
+
+    for (int v = 0; v < n; ++v) {
+        d[v * stride + v] = 0;
+        for (int i = graph.offsets[v]; i < graph.offsets[v + 1]; ++i) {
+            double& entry = d[v * stride + graph.targets[i]];
+            entry = std::min(entry, weightOf(graph, i));
+        }
+    }
+
+    const int tiles = (n + tileSize - 1) / tileSize;
+    auto begin = [](int tile) { return tile * tileSize; };
+    auto end = [n](int tile) { return std::min(n, (tile + 1) * tileSize); };
+
+    // tasks are handed out through a shared cursor, tiles differ in cost at the matrix edge
+    auto parallelTiles = [&](int taskCount, auto task) {
+        std::atomic<int> cursor = 0;
+        runThreads(std::min(threadCount, taskCount), [&](int) {
+            for (int i = cursor++; i < taskCount; i = cursor++) task(i);
+        });
+    };
+
+    for (int k = 0; k < tiles; ++k) {
+        const int kBegin = begin(k), kEnd = end(k);
+        relaxTile(d, stride, kBegin, kEnd, kBegin, kEnd, kBegin, kEnd);
+        if (tiles == 1) break;
+
+        // the rest of block row and column k, they only depend on the diagonal tile
+        parallelTiles(2 * (tiles - 1), [&](int task) {
+            int other = task % (tiles - 1);
+            if (other >= k) ++other;
+            if (task < tiles - 1)
+                relaxTile(d, stride, kBegin, kEnd, begin(other), end(other), kBegin, kEnd);
+            else
+                relaxTile(d, stride, begin(other), end(other), kBegin, kEnd, kBegin, kEnd);
+        });
+
+        // every other tile from its block row and column, which are final for this k
+        parallelTiles((tiles - 1) * (tiles - 1), [&](int task) {
+            int row = task / (tiles - 1), col = task % (tiles - 1);
+            if (row >= k) ++row;
+            if (col >= k) ++col;
+            relaxTile(d, stride, begin(row), end(row), begin(col), end(col), kBegin, kEnd);
+        });
+    }
+}
+
+void dijkstraPerSource(const Graph& graph, DistanceMatrix& matrix, int threadCount) {
+    const int n = matrix.vertexCount;
+    std::atomic<int> nextSource = 0;
+
+    runThreads(std::min(threadCount, std::max(n, 1)), [&](int) {
+        // (distance, vertex) min-heap
+        std::vector<std::pair<double, int>> heap;
+        auto later = [](const auto& lhs, const auto& rhs) { return lhs > rhs; };
+
+        for (int source = nextSource++; source < n; source = nextSource++) {
+            // the row is the distance array, it starts out all infinity
+            double* distance = matrix.distances.data() + static_cast<size_t>(source) * n;
+            distance[source] = 0;
+            heap.push_back({0, source});
+
+            while (!heap.empty()) {
+                std::pop_heap(heap.begin(), heap.end(), later);
+                auto [settled, vertex] = heap.back();
+                heap.pop_back();
+                if (settled > distance[vertex]) continue;
+
+                for (int i = graph.offsets[vertex]; i < graph.offsets[vertex + 1]; ++i) {
+                    double next = settled + weightOf(graph, i);
+                    int target = graph.targets[i];
+                    if (next >= distance[target]) continue;
+                    distance[target] = next;
+                    heap.push_back({next, target});
+                    std::push_heap(heap.begin(), heap.end(), later);
+                }
+            }
+        }
+    });
+}
+
+}  // namespace
+
+AllPairsMethod chooseAllPairsMethod(const Graph& graph) {
+    if (graph.isWeighted() &&
+        std::any_of(graph.weights.begin(), graph.weights.end(), [](double w) { return w < 0; }))
+        return AllPairsMethod::FloydWarshall;
+
+    // n^3 min-plus steps against n Dijkstras of m relaxations and n log n heap operations
+    const double n = graph.vertexCount();
+    const double dijkstra = n * (graph.edgeCount() + n * std::log2(n + 1)) * dijkstraStepCost;
+    return dijkstra < n * n * n ? AllPairsMethod::Dijkstra : AllPairsMethod::FloydWarshall;
+}
+
+DistanceMatrix AllPairsShortestPaths(const Graph& graph, AllPairsMethod method, int threadCount) {
+    DistanceMatrix matrix;
+    matrix.vertexCount = graph.vertexCount();
+    matrix.distances.assign(static_cast<size_t>(matrix.vertexCount) * matrix.vertexCount,
+                            infinity);
+    if (matrix.vertexCount == 0) return matrix;
+
+    threadCount = resolveThreadCount(threadCount);
+    if (method == AllPairsMethod::Automatic) method = chooseAllPairsMethod(graph);
+    if (method == AllPairsMethod::FloydWarshall)
+        floydWarshall(graph, matrix, threadCount);
+    else
+        dijkstraPerSource(graph, matrix, threadCount);
+    return matrix;
+}
+
+bool saveDistanceMatrix(const DistanceMatrix& matrix, const std::string& path) {
+    using namespace distancefile;
+
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = formatVersion;
+    header.byteOrder = byteOrderMark;
+    header.vertexCount = matrix.vertexCount;
+    header.dataOffset = dataOffset;
+    char padding[dataOffset - sizeof(Header)] = {};
+
+    // written next to the target and renamed over it, a failed save leaves the old file alone
+    const std::string partialPath = path + ".partial";
+    std::FILE* file = std::fopen(partialPath.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(padding, sizeof(padding), 1, file) == 1 &&
+                   std::fwrite(matrix.distances.data(), sizeof(double), matrix.distances.size(),
+                               file) == matrix.distances.size();
+    written = std::fclose(file) == 0 && written;
+
+    std::error_code error;
+    if (written) std::filesystem::rename(partialPath, path, error);
+    if (!written || error) {
+        std::filesystem::remove(partialPath, error);
+        return false;
+    }
+    return true;
+}
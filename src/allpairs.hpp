@@ -0,0 +1,64 @@
+#ifndef ALLPAIRS_HPP
+#define ALLPAIRS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "graph.hpp"
+
+// Shortest path distances between every pair of vertex slots, row-major: the distance from
+// `from` to `to` is distances[from * vertexCount + to], infinity when it can't be reached. A
+// graph of n vertices takes 8 n^2 bytes, 3.2 GB at 20k vertices.
+struct DistanceMatrix {
+    int vertexCount = 0;
+    std::vector<double> distances;
+
+    inline double at(int from, int to) const {
+        return this->distances[static_cast<size_t>(from) * this->vertexCount + to];
+    }
+};
+
+// Largest graph a distance matrix is built for: 8 GiB of distances. Past it the allocation
+// alone fails or outgrows the memory of most machines, callers refuse such graphs up front.
+constexpr int maxAllPairsVertices = 1 << 15;
+
+enum class AllPairsMethod { Automatic, FloydWarshall, Dijkstra };
+
+// Floyd-Warshall on dense graphs or with negative weights, one Dijkstra per source otherwise.
+AllPairsMethod chooseAllPairsMethod(const Graph&);
+
+// Distances over threadCount threads (0 picks the hardware concurrency), unweighted graphs
+// weigh 1 per edge like Dijkstra. Floyd-Warshall runs on 64x64 tiles of the matrix: per block of
+// intermediate vertices the diagonal tile is closed first, then the tiles in its row and column,
+// then every other tile with a min-plus product of the two, which is a tight loop over
+// contiguous rows that the compiler vectorises. Per-source Dijkstra writes straight into the
+// rows. Negative weights need Floyd-Warshall, on a negative cycle the distances are meaningless.
+DistanceMatrix AllPairsShortestPaths(const Graph&, AllPairsMethod = AllPairsMethod::Automatic,
+                                     int threadCount = 0);
+
+// Distance matrix files: a header, zero padding up to dataOffset, then vertexCount rows of
+// vertexCount float64 in the writer's byte order, which the header records.
+namespace distancefile {
+
+constexpr char magic[4] = {'G', 'P', 'H', 'D'};
+constexpr std::uint32_t formatVersion = 1;
+constexpr std::uint32_t byteOrderMark = 0x01020304;
+// the rows start on a 64 byte boundary so the file can be mapped and used in place
+constexpr std::uint64_t dataOffset = 64;
+
+struct Header {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t reserved;
+    std::uint64_t vertexCount;
+    std::uint64_t dataOffset;
+};
+
+}  // namespace distancefile
+
+// false when the file can't be written
+bool saveDistanceMatrix(const DistanceMatrix&, const std::string& path);
+
+#endif  // ALLPAIRS_HPP
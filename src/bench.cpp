@@ -0,0 +1,296 @@
+// Times graph construction and the search algorithms on synthetic graphs, no window needed.
+//
+//   graphiz_bench [--vertices N] [--degree D] [--runs R] [--seed S] [--shape random|grid]
+//                 [--threads T]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "allpairs.hpp"
+#include "components.hpp"
+#include "contraction.hpp"
+#include "edge.hpp"
+#include "graph.hpp"
+#include "forcelayout.hpp"
+#include "graphfile.hpp"
+#include "graphstore.hpp"
+#include "importer.hpp"
+#include "parallelbfs.hpp"
+#include "playback.hpp"
+#include "util.hpp"
+#include "vertex.hpp"
+#include "weight.hpp"
+
+namespace {
+
+// all-pairs distances are cubic or close to it, larger graphs take minutes
+constexpr long allPairsVertexLimit = 4000;
+
+struct Options {
+    int vertices = 10000;
+    int degree = 5;
+    int runs = 5;
+    unsigned seed = 1;
+    std::string shape = "random";
+    int threads = 0;
+};
+
+struct Synthetic {
+    std::vector<Vertex> vertices;
+    std::vector<Edge> edges;
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        auto next = [&](const char* name) -> const char* {
+            if (std::strcmp(argv[i], name) != 0 || i + 1 >= argc) return nullptr;
+            return argv[++i];
+        };
+
+        if (const char* value = next("--vertices"))
+            options.vertices = std::atoi(value);
+        else if (const char* value = next("--degree"))
+            options.degree = std::atoi(value);
+        else if (const char* value = next("--runs"))
+            options.runs = std::atoi(value);
+        else if (const char* value = next("--seed"))
+            options.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else if (const char* value = next("--shape"))
+            options.shape = value;
+        else if (const char* value = next("--threads"))
+            options.threads = std::atoi(value);
+        else
+            return false;
+    }
+
+    return options.vertices > 0 && options.degree >= 0 && options.runs > 0 &&
+           options.threads >= 0 && (options.shape == "random" || options.shape == "grid");
+}
+
+// random: every vertex gets `degree` out-edges to uniformly random targets
+// grid: a square lattice with edges to the right and down neighbours, high diameter
+Synthetic generate(const Options& options) {
+    Synthetic graph;
+    std::mt19937 rng(options.seed);
+    std::uniform_int_distribution<int> weight(1, 100);
+
+    int side = 1;
+    while (side * side < options.vertices) ++side;
+
+    graph.vertices.reserve(options.vertices);
+    for (int i = 0; i < options.vertices; ++i) {
+        Vertex& vertex = graph.vertices.emplace_back(
+            Vector2{static_cast<float>(i % side) * 70, static_cast<float>(i / side) * 70}, 30.0f,
+            Color{0, 0, 0, 255});
+        vertex.id = i;
+    }
+
+    auto addEdge = [&](int from, int to) {
+        graph.edges.emplace_back(from, to, Weight(std::int64_t{weight(rng)}));
+    };
+
+    if (options.shape == "grid") {
+        for (int i = 0; i < options.vertices; ++i) {
+            if ((i + 1) % side != 0 && i + 1 < options.vertices) addEdge(i, i + 1);
+            if (i + side < options.vertices) addEdge(i, i + side);
+        }
+    } else {
+        std::uniform_int_distribution<int> target(0, options.vertices - 1);
+        graph.edges.reserve(static_cast<size_t>(options.vertices) * options.degree);
+        for (int i = 0; i < options.vertices; ++i)
+            for (int d = 0; d < options.degree; ++d) addEdge(i, target(rng));
+    }
+
+    return graph;
+}
+
+// runs `work` options.runs times and reports the best and mean wall time
+void measure(const char* name, const Options& options, long vertexCount, long edgeCount,
+             const std::function<void()>& work) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> seconds;
+
+    for (int run = 0; run < options.runs; ++run) {
+        auto start = Clock::now();
+        work();
+        seconds.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    double best = *std::min_element(seconds.begin(), seconds.end());
+    double mean = 0;
+    for (double s : seconds) mean += s / seconds.size();
+
+    std::printf("%-22s best %10.3f ms  mean %10.3f ms  %10.2f M edges/s  %10.2f ns/vertex\n",
+                name, best * 1e3, mean * 1e3, edgeCount / best / 1e6, best * 1e9 / vertexCount);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s [--vertices N] [--degree D] [--runs R] [--seed S] "
+                     "[--shape random|grid] [--threads T]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    Synthetic synthetic = generate(options);
+    const long vertexCount = static_cast<long>(synthetic.vertices.size());
+    const long edgeCount = static_cast<long>(synthetic.edges.size());
+
+    std::printf("%s graph: %ld vertices, %ld edges, %d runs, seed %u\n", options.shape.c_str(),
+                vertexCount, edgeCount, options.runs, options.seed);
+
+    Graph graph;
+    measure("createGraph", options, vertexCount, edgeCount,
+            [&] { graph = createGraph(synthetic.vertices, synthetic.edges); });
+
+    Graph weighted;
+    measure("createGraphWeighted", options, vertexCount, edgeCount,
+            [&] { weighted = createGraphWeighted(synthetic.vertices, synthetic.edges); });
+
+    // the file is written next to the working directory and removed afterwards
+    const std::string filePath = "graphiz_bench.gphz";
+    GraphStore store;
+    measure("GraphStore::load", options, vertexCount, edgeCount,
+            [&] { store.load(synthetic.vertices, synthetic.edges); });
+    measure("saveGraph", options, vertexCount, edgeCount, [&] { saveGraph(store, filePath); });
+    measure("MappedGraphFile::open", options, vertexCount, edgeCount,
+            [&] { MappedGraphFile::open(filePath); });
+    measure("MappedGraphFile::graph", options, vertexCount, edgeCount,
+            [&] { weighted = *MappedGraphFile::open(filePath)->graph(true); });
+    measure("loadGraph", options, vertexCount, edgeCount, [&] { loadGraph(filePath, store); });
+    std::remove(filePath.c_str());
+
+    const std::string edgeListPath = "graphiz_bench.txt";
+    if (std::FILE* file = std::fopen(edgeListPath.c_str(), "w")) {
+        for (const Edge& edge : synthetic.edges)
+            std::fprintf(file, "%d %d %s\n", edge.fromId, edge.toId, edge.weight.toString().c_str());
+        std::fclose(file);
+    }
+    ImportOptions importOptions;
+    importOptions.threadCount = options.threads;
+    measure("importGraph", options, vertexCount, edgeCount, [&] {
+        importGraph(edgeListPath, ImportFormat::EdgeList, store, importOptions);
+    });
+    std::remove(edgeListPath.c_str());
+
+    // a full multilevel layout to convergence, from the imported grid positions
+    LayoutOptions layoutOptions;
+    layoutOptions.threadCount = options.threads;
+    ForceLayout layout(layoutOptions);
+    measure("ForceLayout", options, vertexCount, edgeCount, [&] {
+        layout.start(store);
+        layout.wait();
+    });
+
+    // results are kept alive outside the timed lambdas so the work can't be optimised away
+    size_t visited = 0;
+    measure("BFS", options, vertexCount, edgeCount, [&] { visited = BFS(graph, 0).size(); });
+    std::printf("%-22s reached %zu vertices\n", "", visited);
+
+    ReverseGraph reverse = createReverseGraph(graph);
+    measure("ParallelBFS", options, vertexCount, edgeCount,
+            [&] { visited = ParallelBFS(graph, 0, options.threads, &reverse).order.size(); });
+    std::printf("%-22s reached %zu vertices\n", "", visited);
+
+    measure("DFS", options, vertexCount, edgeCount, [&] { visited = DFS(graph, 0).size(); });
+    std::printf("%-22s reached %zu vertices\n", "", visited);
+
+    int components = 0;
+    measure("WeaklyConnected", options, vertexCount, edgeCount,
+            [&] { components = WeaklyConnectedComponents(graph, options.threads).count; });
+    std::printf("%-22s found %d components\n", "", components);
+    measure("StronglyConnected", options, vertexCount, edgeCount,
+            [&] { components = StronglyConnectedComponents(graph).count; });
+    std::printf("%-22s found %d components\n", "", components);
+
+    // plays a BFS to the end, then seeks back to the middle by undoing marks
+    int steps = 0;
+    measure("Playback seek", options, vertexCount, edgeCount, [&] {
+        Playback playback(graph, Traversal(std::in_place_type<BFSTraversal>, graph, 0));
+        steps = playback.totalSteps();
+        playback.seek(steps);
+        playback.seek(steps / 2);
+    });
+    std::printf("%-22s played %d steps\n", "", steps);
+
+    measure("Dijkstra", options, vertexCount, edgeCount,
+            [&] {
+                auto distance = Dijkstra(weighted, 0).distance;
+                visited = std::count_if(distance.begin(), distance.end(),
+                                        [](double d) { return std::isfinite(d); });
+            });
+    std::printf("%-22s settled %zu vertices\n", "", visited);
+
+    // corner to corner on the generated positions, compared with Dijkstra stopping at the target
+    std::vector<Vector2> positions;
+    for (const Vertex& vertex : synthetic.vertices) positions.push_back(vertex.pos);
+    const double unit = minimumDistanceUnit(weighted, positions);
+    const int target = static_cast<int>(vertexCount) - 1;
+    AStarResult aStar;
+    measure("AStar", options, vertexCount, edgeCount,
+            [&] { aStar = AStar(weighted, positions, 0, target, unit); });
+    AStarResult unguided = AStar(weighted, positions, 0, target, INFINITY);
+    std::printf("%-22s expanded %d vertices, Dijkstra %d\n", "", aStar.expanded,
+                unguided.expanded);
+
+    // corner to corner nothing can be pruned, every vertex of the grid is on a path to the far
+    // corner. With one unit of weight per step and the target half way along the first row the
+    // straight-line bound is tight, A* stays on the row while Dijkstra settles a triangle
+    if (options.shape == "grid") {
+        Graph steps = weighted;
+        steps.weights.assign(steps.targets.size(), 1);
+        int side = 1;
+        while (static_cast<long>(side) * side < vertexCount) ++side;
+        const int rowTarget = side / 2;
+        const double stepUnit = minimumDistanceUnit(steps, positions);
+        measure("AStar along a row", options, vertexCount, edgeCount,
+                [&] { aStar = AStar(steps, positions, 0, rowTarget, stepUnit); });
+        unguided = AStar(steps, positions, 0, rowTarget, INFINITY);
+        std::printf("%-22s expanded %d vertices, Dijkstra %d\n", "", aStar.expanded,
+                    unguided.expanded);
+    }
+
+    // random graphs have no small separators and contract into a dense core, the hierarchy is
+    // only timed on grids
+    if (options.shape == "grid") {
+        std::optional<ContractionHierarchy> hierarchy;
+        measure("ContractionHierarchy", options, vertexCount, edgeCount,
+                [&] { hierarchy = ContractionHierarchy::build(weighted); });
+        std::printf("%-22s added %d shortcuts\n", "", hierarchy->shortcutCount());
+
+        HierarchyQuery query(*hierarchy);
+        HierarchyPath path;
+        measure("HierarchyQuery", options, vertexCount, edgeCount,
+                [&] { path = query.shortestPath(0, target); });
+        std::printf("%-22s settled %d vertices, distance %g (A* %g)\n", "", path.settled,
+                    path.distance, aStar.distance);
+    }
+
+    if (vertexCount <= allPairsVertexLimit) {
+        AllPairsMethod chosen = chooseAllPairsMethod(weighted);
+        for (AllPairsMethod method : {AllPairsMethod::FloydWarshall, AllPairsMethod::Dijkstra}) {
+            bool floyd = method == AllPairsMethod::FloydWarshall;
+            measure(floyd ? "AllPairs FloydWarshall" : "AllPairs Dijkstra", options, vertexCount,
+                    edgeCount,
+                    [&] { AllPairsShortestPaths(weighted, method, options.threads); });
+        }
+        std::printf("%-22s picks %s\n", "",
+                    chosen == AllPairsMethod::FloydWarshall ? "FloydWarshall" : "Dijkstra");
+    }
+
+    return 0;
+}
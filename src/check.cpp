@@ -0,0 +1,618 @@
+// Checks the algorithms against simple reference implementations on small random graphs, no
+// window needed. ctest runs it; every failed check is reported and the exit status is 1.
+//
+//   graphiz_check [--seed S]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "allpairs.hpp"
+#include "components.hpp"
+#include "contraction.hpp"
+#include "graph.hpp"
+#include "graphfile.hpp"
+#include "graphstore.hpp"
+#include "importer.hpp"
+#include "parallelbfs.hpp"
+#include "playback.hpp"
+#include "traversal.hpp"
+#include "util.hpp"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (ok) return;
+    std::printf("FAIL %s\n", what.c_str());
+    ++failures;
+}
+
+// CSR over m uniformly random edges, weights in [0, maxWeight] or unweighted when maxWeight is 0
+Graph randomGraph(std::mt19937& rng, int vertexCount, int edgeCount, int maxWeight) {
+    std::uniform_int_distribution<int> vertex(0, vertexCount - 1);
+    std::uniform_int_distribution<int> weight(0, std::max(maxWeight, 0));
+    std::vector<std::tuple<int, int, double>> edges;
+    for (int i = 0; i < edgeCount; ++i) edges.push_back({vertex(rng), vertex(rng), weight(rng)});
+    std::sort(edges.begin(), edges.end());
+
+    Graph graph;
+    graph.offsets.assign(vertexCount + 1, 0);
+    auto offsets = graph.offsets.writable();
+    for (auto [from, to, w] : edges) ++offsets[from + 1];
+    for (int v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+    for (auto [from, to, w] : edges) {
+        graph.targets.push_back(to);
+        if (maxWeight > 0) graph.weights.push_back(w);
+    }
+    return graph;
+}
+
+// marks reached by stepping back and seeking have to be the ones a forward replay saw
+void checkPlayback(std::mt19937& rng) {
+    for (int round = 0; round < 30; ++round) {
+        int vertexCount = 1 + static_cast<int>(rng() % 200);
+        Graph graph = randomGraph(rng, vertexCount, static_cast<int>(rng() % (3 * vertexCount)),
+                                  round % 2 == 0 ? 0 : 20);
+        int start = static_cast<int>(rng() % vertexCount);
+        auto traversal = [&] {
+            switch (round % 3) {
+                case 0: return Traversal(std::in_place_type<BFSTraversal>, graph, start);
+                case 1: return Traversal(std::in_place_type<DFSTraversal>, graph, start);
+                default: return Traversal(std::in_place_type<DijkstraTraversal>, graph, start);
+            }
+        };
+
+        Playback forward(graph, traversal());
+        std::vector<std::vector<VertexMark>> expected{forward.marks()};
+        while (forward.stepForward()) expected.push_back(forward.marks());
+        const int total = static_cast<int>(expected.size()) - 1;
+        const std::string name = "playback round " + std::to_string(round);
+
+        Playback playback(graph, traversal());
+        playback.seek(total);
+        check(playback.position() == total && playback.marks() == expected[total],
+              name + " seek to end");
+        for (int step = total - 1; step >= 0; --step) {
+            playback.stepBack();
+            check(playback.position() == step && playback.marks() == expected[step],
+                  name + " step back to " + std::to_string(step));
+        }
+        for (int i = 0; i < 20; ++i) {
+            int step = static_cast<int>(rng() % (total + 1));
+            playback.seek(step);
+            check(playback.position() == step && playback.marks() == expected[step],
+                  name + " seek to " + std::to_string(step));
+        }
+    }
+}
+
+// hop count from start by the textbook queue BFS, -1 where it isn't reached
+std::vector<int> bfsLevels(const Graph& graph, int start) {
+    std::vector<int> level(graph.vertexCount(), -1);
+    std::vector<int> queue{start};
+    level[start] = 0;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int vertex = queue[head];
+        for (int i = graph.offsets[vertex]; i < graph.offsets[vertex + 1]; ++i) {
+            int target = graph.targets[i];
+            if (level[target] != -1) continue;
+            level[target] = level[vertex] + 1;
+            queue.push_back(target);
+        }
+    }
+    return level;
+}
+
+// levels and the visit order have to match the serial BFS, on trees and on random graphs with
+// several parents per vertex, whatever the thread count
+void checkParallelBFS(std::mt19937& rng) {
+    for (int round = 0; round < 20; ++round) {
+        // the last rounds are big enough for levels past the threshold that starts threads
+        int vertexCount = round < 18 ? 1 + static_cast<int>(rng() % 3000) : 40000;
+        Graph graph;
+        const bool tree = round % 2 == 0;
+        if (tree) {
+            // random recursive tree, shallow enough that the middle levels go bottom-up
+            graph.offsets.assign(vertexCount + 1, 0);
+            auto offsets = graph.offsets.writable();
+            std::vector<int> parent(vertexCount, -1);
+            for (int v = 1; v < vertexCount; ++v) {
+                parent[v] = static_cast<int>(rng() % v);
+                ++offsets[parent[v] + 1];
+            }
+            for (int v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+            graph.targets.resize(vertexCount - 1);
+            auto targets = graph.targets.writable();
+            std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+            for (int v = 1; v < vertexCount; ++v) targets[fill[parent[v]]++] = v;
+        } else {
+            graph = randomGraph(rng, vertexCount, static_cast<int>(rng() % (8 * vertexCount)), 0);
+        }
+        const int start = tree ? 0 : static_cast<int>(rng() % vertexCount);
+        const std::string name = "parallel bfs round " + std::to_string(round);
+
+        std::vector<int> serial = BFS(graph, start);
+        std::vector<int> level = bfsLevels(graph, start);
+        BFSResult single = ParallelBFS(graph, start, 1);
+        BFSResult threaded = ParallelBFS(graph, start, 3);
+
+        check(single.level == level, name + " levels");
+        check(threaded.order == single.order && threaded.level == single.level,
+              name + " same result on 1 and 3 threads");
+        check(single.order == serial, name + " order");
+    }
+}
+
+// A* with the smallest exact unit has to find Dijkstra's distances, and stop after at most V
+// visits even on negative weights
+void checkAStar(std::mt19937& rng) {
+    std::uniform_real_distribution<float> coordinate(0, 1000);
+    for (int round = 0; round < 30; ++round) {
+        int vertexCount = 1 + static_cast<int>(rng() % 300);
+        Graph graph = randomGraph(rng, vertexCount, static_cast<int>(rng() % (4 * vertexCount)),
+                                  50);
+        std::vector<Vector2> positions(vertexCount);
+        for (Vector2& position : positions) position = {coordinate(rng), coordinate(rng)};
+        const std::string name = "astar round " + std::to_string(round);
+
+        // weights from 1 up keep the unit finite, so the guidance is on
+        for (double& weight : graph.weights.writable()) weight += 1;
+        double unit = minimumDistanceUnit(graph, positions);
+        for (int query = 0; query < 10; ++query) {
+            int start = static_cast<int>(rng() % vertexCount);
+            int target = static_cast<int>(rng() % vertexCount);
+            double expected = Dijkstra(graph, start).distance[target];
+            check(AStar(graph, positions, start, target, unit).distance == expected,
+                  name + " distance " + std::to_string(start) + " to " + std::to_string(target));
+        }
+
+        for (double& weight : graph.weights.writable()) weight -= 26;
+        AStarResult negative = AStar(graph, positions, 0, vertexCount - 1, 1);
+        check(negative.expanded <= vertexCount, name + " negative weights end");
+    }
+}
+
+// hierarchy distances and paths have to be Dijkstra's, and a builder asked for one graph after
+// another has to end up with the last one
+void checkHierarchy(std::mt19937& rng) {
+    for (int round = 0; round < 20; ++round) {
+        int vertexCount = 1 + static_cast<int>(rng() % 300);
+        Graph graph = randomGraph(rng, vertexCount, static_cast<int>(rng() % (4 * vertexCount)),
+                                  round % 4 == 0 ? 0 : 30);
+        const std::string name = "hierarchy round " + std::to_string(round);
+        auto hierarchy = ContractionHierarchy::build(graph);
+        HierarchyQuery query(*hierarchy);
+
+        for (int i = 0; i < 20; ++i) {
+            int source = static_cast<int>(rng() % vertexCount);
+            int target = static_cast<int>(rng() % vertexCount);
+            const std::string pair = std::to_string(source) + " to " + std::to_string(target);
+            DijkstraResult expected = Dijkstra(graph, source);
+            HierarchyPath found = query.shortestPath(source, target);
+            check(found.distance == expected.distance[target], name + " distance " + pair);
+
+            // the path has to use real edges and add up to the distance
+            double length = 0;
+            bool connected = found.path.empty() || found.path.front() == source;
+            for (size_t j = 1; connected && j < found.path.size(); ++j) {
+                int from = found.path[j - 1];
+                double cheapest = std::numeric_limits<double>::infinity();
+                for (int e = graph.offsets[from]; e < graph.offsets[from + 1]; ++e)
+                    if (graph.targets[e] == found.path[j])
+                        cheapest = std::min(cheapest, graph.isWeighted() ? graph.weights[e] : 1);
+                length += cheapest;
+                connected = cheapest != std::numeric_limits<double>::infinity();
+            }
+            if (!found.path.empty())
+                check(connected && found.path.back() == target && length == found.distance,
+                      name + " path " + pair);
+        }
+    }
+
+    HierarchyBuilder builder;
+    Graph graph = randomGraph(rng, 500, 2000, 30);
+    for (graph.version = 1; graph.version <= 5; ++graph.version) builder.rebuild(graph);
+    for (int wait = 0; wait < 600 && builder.building(); ++wait)
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto newest = builder.current();
+    check(newest != nullptr && newest->version() == 5, "hierarchy builder keeps the last rebuild");
+
+    // 0 -> 1 -> 2 -> 3 only beats 0 -> 2 -> 3 through the -3 edge, graphiz_query builds the
+    // same way
+    Graph negative;
+    negative.offsets = {0, 2, 3, 4, 4};
+    negative.targets = {1, 2, 2, 3};
+    negative.weights = {5, 4, -3, 1};
+    check(!ContractionHierarchy::build(negative).has_value(),
+          "hierarchy build refuses negative weights");
+
+    graph.weights.writable()[0] = -1;
+    ++graph.version;
+    check(!builder.rebuild(graph) && builder.version() == graph.version && !builder.building(),
+          "hierarchy builder skips negative weights");
+}
+
+// Floyd-Warshall has to agree with a Dijkstra per source, on more than one tile and thread, and
+// with Bellman-Ford on negative weights without negative cycles
+void checkAllPairs(std::mt19937& rng) {
+    for (int round = 0; round < 12; ++round) {
+        const bool negative = round % 4 == 3;
+        int vertexCount = 1 + static_cast<int>(rng() % 200);
+        Graph graph = randomGraph(rng, vertexCount, static_cast<int>(rng() % (4 * vertexCount)),
+                                  round % 3 == 0 && !negative ? 0 : 30);
+        const std::string name = "all pairs round " + std::to_string(round);
+        std::vector<double> expected;
+
+        if (negative) {
+            // edges that go up in index can't close a cycle, the rest are dropped
+            Graph upward;
+            for (int v = 0; v < vertexCount; ++v) {
+                for (int e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e) {
+                    if (graph.targets[e] <= v) continue;
+                    upward.targets.push_back(graph.targets[e]);
+                    upward.weights.push_back(graph.weights[e] - 10);
+                }
+                upward.offsets.push_back(static_cast<int>(upward.targets.size()));
+            }
+            graph = std::move(upward);
+            for (int source = 0; source < vertexCount; ++source) {
+                std::vector<double> distance(vertexCount, std::numeric_limits<double>::infinity());
+                distance[source] = 0;
+                for (int pass = 1; pass < vertexCount; ++pass)
+                    for (int v = 0; v < vertexCount; ++v)
+                        for (int e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e)
+                            distance[graph.targets[e]] = std::min(distance[graph.targets[e]],
+                                                                  distance[v] + graph.weights[e]);
+                expected.insert(expected.end(), distance.begin(), distance.end());
+            }
+        } else {
+            for (int source = 0; source < vertexCount; ++source) {
+                std::vector<double> distance = Dijkstra(graph, source).distance;
+                expected.insert(expected.end(), distance.begin(), distance.end());
+            }
+        }
+
+        for (int threads : {1, 3}) {
+            DistanceMatrix floyd =
+                AllPairsShortestPaths(graph, AllPairsMethod::FloydWarshall, threads);
+            check(floyd.distances == expected,
+                  name + " floyd-warshall on " + std::to_string(threads) + " threads");
+        }
+    }
+}
+
+// components against plain reachability: weak ones numbered by their smallest vertex on any
+// thread count, strong ones the mutually reachable sets with edges only leading to lower numbers
+void checkComponents(std::mt19937& rng) {
+    for (int round = 0; round < 20; ++round) {
+        int vertexCount = 1 + static_cast<int>(rng() % 150);
+        Graph graph = randomGraph(rng, vertexCount, static_cast<int>(rng() % (2 * vertexCount)),
+                                  0);
+        const std::string name = "components round " + std::to_string(round);
+
+        std::vector<std::vector<int>> reach;
+        for (int v = 0; v < vertexCount; ++v) reach.push_back(bfsLevels(graph, v));
+
+        // weak: reachability with every edge also going back
+        std::vector<std::vector<int>> neighbours(vertexCount);
+        for (int v = 0; v < vertexCount; ++v) {
+            for (int e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e) {
+                neighbours[v].push_back(graph.targets[e]);
+                neighbours[graph.targets[e]].push_back(v);
+            }
+        }
+        Graph undirected;
+        for (const auto& list : neighbours) {
+            for (int target : list) undirected.targets.push_back(target);
+            undirected.offsets.push_back(static_cast<int>(undirected.targets.size()));
+        }
+        std::vector<int> weak(vertexCount, -1);
+        int weakCount = 0;
+        for (int v = 0; v < vertexCount; ++v) {
+            if (weak[v] != -1) continue;
+            std::vector<int> level = bfsLevels(undirected, v);
+            for (int u = 0; u < vertexCount; ++u)
+                if (level[u] != -1) weak[u] = weakCount;
+            ++weakCount;
+        }
+        for (int threads : {1, 3}) {
+            Components found = WeaklyConnectedComponents(graph, threads);
+            check(found.count == weakCount && found.component == weak,
+                  name + " weak on " + std::to_string(threads) + " threads");
+        }
+
+        Components strong = StronglyConnectedComponents(graph);
+        std::vector<int> seen;
+        bool same = true;
+        for (int u = 0; u < vertexCount; ++u) {
+            for (int v = 0; v < vertexCount; ++v) {
+                bool mutual = reach[u][v] != -1 && reach[v][u] != -1;
+                same &= mutual == (strong.component[u] == strong.component[v]);
+            }
+            seen.push_back(strong.component[u]);
+        }
+        std::sort(seen.begin(), seen.end());
+        seen.erase(std::unique(seen.begin(), seen.end()), seen.end());
+        bool ordered = true;
+        for (int v = 0; v < vertexCount; ++v)
+            for (int e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e)
+                ordered &= strong.component[graph.targets[e]] <= strong.component[v];
+        check(same && strong.count == static_cast<int>(seen.size()) && ordered &&
+                  seen.front() == 0 && seen.back() == strong.count - 1,
+              name + " strong");
+    }
+}
+
+// every format the importer reads, and every Matrix Market field and symmetry pair: the store
+// has to hold exactly the edges the file stands for, or the import has to fail
+void checkImport() {
+    // (from, to, weight), weight nan when the edge is unweighted
+    using Edges = std::vector<std::tuple<int, int, double>>;
+    const double none = std::numeric_limits<double>::quiet_NaN();
+    const auto directory = std::filesystem::temp_directory_path();
+
+    auto imported = [&](const std::string& name, const std::string& text, ImportFormat format,
+                        int expectedVertices, Edges expected, const std::string& what) {
+        const std::string path = (directory / name).string();
+        if (std::FILE* file = std::fopen(path.c_str(), "w")) {
+            std::fputs(text.c_str(), file);
+            std::fclose(file);
+        }
+        GraphStore store;
+        std::string error;
+        const bool ok = importGraph(path, format, store, {}, &error);
+        std::remove(path.c_str());
+        if (expectedVertices < 0) {
+            check(!ok && !error.empty(), what + " rejected");
+            return;
+        }
+
+        Edges found;
+        for (const Edge& edge : store.edges())
+            found.push_back(
+                {edge.fromId, edge.toId, edge.weighted ? edge.weight.asDouble() : none});
+        auto byEndpoints = [](const auto& lhs, const auto& rhs) {
+            return std::tie(std::get<0>(lhs), std::get<1>(lhs)) <
+                   std::tie(std::get<0>(rhs), std::get<1>(rhs));
+        };
+        std::sort(found.begin(), found.end(), byEndpoints);
+        std::sort(expected.begin(), expected.end(), byEndpoints);
+        bool same =
+            ok && store.vertexCount() == expectedVertices && found.size() == expected.size();
+        for (size_t i = 0; same && i < found.size(); ++i) {
+            auto [from, to, weight] = found[i];
+            auto [wantFrom, wantTo, wantWeight] = expected[i];
+            same = from == wantFrom && to == wantTo &&
+                   (std::isnan(wantWeight) ? std::isnan(weight) : weight == wantWeight);
+        }
+        check(same, what + (ok ? "" : ": " + error));
+    };
+
+    imported("graphiz_check.txt", "# comment\n0 1 2.5\n1 2\n% also a comment\n2 0 -4\n",
+             ImportFormat::EdgeList, 3, {{0, 1, 2.5}, {1, 2, none}, {2, 0, -4}}, "edge list");
+    imported("graphiz_check.txt", "0 1 x\n", ImportFormat::EdgeList, -1, {}, "edge list weight");
+    imported("graphiz_check.gr", "c comment\np sp 3 2\na 1 2 7\na 3 1 1\n",
+             ImportFormat::Dimacs, 3, {{0, 1, 7}, {2, 0, 1}}, "dimacs");
+    imported("graphiz_check.gr", "p sp 2 1\na 1 3 7\n", ImportFormat::Dimacs, -1, {},
+             "dimacs id above the count");
+
+    for (std::string field : {"real", "double", "integer", "pattern", "complex"}) {
+        for (std::string symmetry : {"general", "symmetric", "skew-symmetric", "hermitian"}) {
+            const bool pattern = field == "pattern";
+            const std::string what = "matrix market " + field + " " + symmetry;
+            std::string text = "%%MatrixMarket matrix coordinate " + field + " " + symmetry +
+                               "\n% comment\n3 3 3\n";
+            text += pattern ? "2 1\n3 1\n3 3\n" : "2 1 4\n3 1 -2\n3 3 5\n";
+
+            if (field == "complex" || symmetry == "hermitian" ||
+                (pattern && symmetry == "skew-symmetric")) {
+                imported("graphiz_check.mtx", text, ImportFormat::MatrixMarket, -1, {}, what);
+                continue;
+            }
+            auto value = [&](double number) { return pattern ? none : number; };
+            Edges expected{{1, 0, value(4)}, {2, 0, value(-2)}, {2, 2, value(5)}};
+            if (symmetry != "general") {
+                const double sign = symmetry == "skew-symmetric" ? -1 : 1;
+                expected.push_back({0, 1, value(sign * 4)});
+                expected.push_back({0, 2, value(sign * -2)});
+            }
+            imported("graphiz_check.mtx", text, ImportFormat::MatrixMarket, 3, expected, what);
+        }
+    }
+}
+
+struct ModelEdge {
+    int from, to;
+    double weight;
+};
+
+// both snapshots against a CSR built from scratch out of the edge ids per source
+void checkSnapshots(GraphStore& store, const std::vector<std::vector<int>>& order,
+                    const std::unordered_map<int, ModelEdge>& model, const std::string& name) {
+    Graph expected;
+    for (const auto& ids : order) {
+        for (int edgeId : ids) {
+            expected.targets.push_back(model.at(edgeId).to);
+            expected.weights.push_back(model.at(edgeId).weight);
+        }
+        expected.offsets.push_back(static_cast<int>(expected.targets.size()));
+    }
+    const Graph& weighted = store.weightedGraph();
+    check(weighted.offsets == expected.offsets && weighted.targets == expected.targets &&
+              weighted.weights == expected.weights && weighted.version == store.version(),
+          name + " weighted snapshot");
+    const Graph& unweighted = store.graph();
+    check(unweighted.offsets == expected.offsets && unweighted.targets == expected.targets &&
+              unweighted.weights.empty() && unweighted.version == store.version(),
+          name + " unweighted snapshot");
+}
+
+// the cached snapshots have to match a CSR built from scratch after any mix of edits, with weight
+// edits patched in and leaving the topology version alone, also when they come from a file
+void checkGraphStore(std::mt19937& rng) {
+    for (int round = 0; round < 10; ++round) {
+        GraphStore store;
+        std::vector<bool> alive;
+        // edge ids per source in insertion order, and what every live edge id connects
+        std::vector<std::vector<int>> order;
+        std::unordered_map<int, ModelEdge> model;
+        const std::string name = "graph store round " + std::to_string(round);
+
+        for (int step = 0; step < 400; ++step) {
+            const int slots = static_cast<int>(alive.size());
+            const unsigned long topology = store.topologyVersion();
+            const int action = static_cast<int>(rng() % 10);
+            if (action == 0 || slots < 2) {
+                int id = store.addVertex({0, 0}, 1, {0, 0, 0, 255}).id;
+                if (id == slots) {
+                    alive.push_back(true);
+                    order.emplace_back();
+                } else {
+                    alive[id] = true;
+                }
+            } else if (action == 1) {
+                int id = static_cast<int>(rng() % slots);
+                if (!alive[id]) continue;
+                store.removeVertex(id);
+                alive[id] = false;
+                order[id].clear();
+                for (auto& ids : order)
+                    std::erase_if(ids, [&](int edgeId) { return model[edgeId].to == id; });
+                std::erase_if(model, [&](const auto& entry) {
+                    return entry.second.from == id || entry.second.to == id;
+                });
+            } else if (action < 6) {
+                int from = static_cast<int>(rng() % slots), to = static_cast<int>(rng() % slots);
+                Edge* edge = store.addEdge(Edge(from, to, Weight(std::int64_t(rng() % 50))));
+                if (edge == nullptr) continue;
+                order[from].push_back(edge->id);
+                model[edge->id] = {from, to, edge->weight.asDouble()};
+            } else if (!model.empty()) {
+                auto picked = std::next(model.begin(), static_cast<long>(rng() % model.size()));
+                const int edgeId = picked->first;
+                if (action == 6) {
+                    std::erase(order[picked->second.from], edgeId);
+                    model.erase(picked);
+                    store.removeEdge(edgeId);
+                } else {
+                    double weight = static_cast<double>(rng() % 50) - 10;
+                    picked->second.weight = weight;
+                    store.setWeight(edgeId, Weight(weight));
+                    check(store.topologyVersion() == topology, name + " weight edit topology");
+                }
+            }
+
+            if (rng() % 4 == 0)
+                checkSnapshots(store, order, model, name + " step " + std::to_string(step));
+        }
+
+        // a loaded file serves the snapshots from the mapping until a weight edit copies them
+        const std::string path =
+            (std::filesystem::temp_directory_path() / "graphiz_check.gphz").string();
+        GraphStore loaded;
+        check(saveGraph(store, path) && loadGraph(path, loaded), name + " save and load");
+        check(loaded.weightedGraph().targets.borrowed() && loaded.graph().targets.borrowed(),
+              name + " loaded snapshots borrow the file");
+        checkSnapshots(loaded, order, model, name + " loaded");
+        if (!model.empty()) {
+            model.begin()->second.weight = -5;
+            loaded.setWeight(model.begin()->first, Weight(-5.0));
+            checkSnapshots(loaded, order, model, name + " loaded and reweighted");
+        }
+        auto file = MappedGraphFile::open(path);
+        std::remove(path.c_str());
+        std::optional<Graph> mapped = file.has_value() ? file->graph(true) : std::nullopt;
+        file.reset();
+        check(mapped.has_value() && mapped->targets == loaded.graph().targets &&
+                  mapped->offsets == loaded.graph().offsets,
+              name + " mapped graph outlives the file object");
+    }
+
+    // load keeps the first of repeated ids and (from, to) pairs and drops dangling edges, the
+    // lookups it leaves to their first use have to see the same
+    {
+        GraphStore store;
+        std::vector<Vertex> vertices(3, Vertex({0, 0}, 1, {0, 0, 0, 255}));
+        vertices[2].usable = false;
+        std::vector<Edge> edges{Edge(0, 1, Weight(1.0)), Edge(1, 0, Weight(2.0)),
+                                Edge(0, 1, Weight(3.0)), Edge(1, 2, Weight(4.0)),
+                                Edge(1, 1, Weight(5.0))};
+        edges[4].id = edges[1].id;
+        const int first = edges[0].id, second = edges[1].id;
+        store.load(vertices, edges);
+        check(store.edges().size() == 2 && store.findEdge(0, 1) != nullptr &&
+                  store.findEdge(0, 1)->weight.asDouble() == 1 && store.findEdge(1, 1) == nullptr &&
+                  store.findEdge(second) != nullptr && store.findEdge(second)->toId == 0 &&
+                  store.spatialIndex().edgesIn({-10, -10, 20, 20}).size() == 2,
+              "load drops repeats and dangling edges");
+        store.removeEdge(first);
+        check(store.findEdge(0, 1) == nullptr && store.outEdges(1).size() == 1 &&
+                  store.spatialIndex().edgesIn({-10, -10, 20, 20}).size() == 1,
+              "edit after load");
+    }
+
+    // the grid is only built on its first use, edits made before that have to end up in it
+    {
+        GraphStore store;
+        store.load(std::vector<Vertex>(2, Vertex({0, 0}, 1, {0, 0, 0, 255})), {Edge(0, 1)});
+        store.addVertex({5, 5}, 1, {0, 0, 0, 255});
+        store.removeVertex(0);
+        const SpatialIndex& index = store.spatialIndex();
+        check(index.verticesIn({-10, -10, 20, 20}).size() == 2 &&
+                  index.edgesIn({-10, -10, 20, 20}).empty(),
+              "grid built after load and edits");
+    }
+
+    // compacting renames default labels along with the ids, typed ones stay
+    GraphStore store;
+    for (int i = 0; i < 4; ++i) store.addVertex({0, 0}, 1, {0, 0, 0, 255});
+    store.resolve(store.handle(3))->label = "typed";
+    store.removeVertex(0);
+    store.compact();
+    check(store.vertex(0).label == "V0" && store.vertex(1).label == "V1" &&
+              store.vertex(2).label == "typed",
+          "compact renames default labels");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            std::fprintf(stderr, "usage: %s [--seed S]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    checkPlayback(rng);
+    checkParallelBFS(rng);
+    checkAStar(rng);
+    checkHierarchy(rng);
+    checkGraphStore(rng);
+    checkAllPairs(rng);
+    checkComponents(rng);
+    checkImport();
+
+    std::printf("%s, seed %u\n", failures == 0 ? "all checks passed" : "checks failed", seed);
+    return failures == 0 ? 0 : 1;
+}
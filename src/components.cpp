@@ -0,0 +1,119 @@
+#include "components.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+
+namespace {
+
+// vertices whose edges a thread takes at a time
+constexpr int unionChunk = 4096;
+
+// the relaxed orderings are enough, every value is a vertex index and nothing else is published
+// through them
+int findRoot(std::vector<std::atomic<int>>& parent, int vertex) {
+    for (;;) {
+        int up = parent[vertex].load(std::memory_order_relaxed);
+        if (up == vertex) return vertex;
+        int upper = parent[up].load(std::memory_order_relaxed);
+        // halving: skip the parent, fine to lose against another thread doing the same
+        if (up != upper)
+            parent[vertex].compare_exchange_weak(up, upper, std::memory_order_relaxed);
+        vertex = upper;
+    }
+}
+
+void unite(std::vector<std::atomic<int>>& parent, int a, int b) {
+    for (;;) {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        if (a == b) return;
+        if (a < b) std::swap(a, b);
+        // a is only still a root if nobody linked it in the meantime
+        int expected = a;
+        if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+    }
+}
+
+}  // namespace
+
+Components WeaklyConnectedComponents(const Graph& graph, int threadCount) {
+    const int vertexCount = graph.vertexCount();
+    std::vector<std::atomic<int>> parent(vertexCount);
+    for (int vertex = 0; vertex < vertexCount; ++vertex) parent[vertex] = vertex;
+
+    const int chunks = (vertexCount + unionChunk - 1) / unionChunk;
+    std::atomic<int> nextChunk = 0;
+    runThreads(std::min(resolveThreadCount(threadCount), std::max(chunks, 1)), [&](int) {
+        for (int chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+            int end = std::min(vertexCount, (chunk + 1) * unionChunk);
+            for (int from = chunk * unionChunk; from < end; ++from)
+                for (int i = graph.offsets[from]; i < graph.offsets[from + 1]; ++i)
+                    unite(parent, from, graph.targets[i]);
+        }
+    });
+
+    // roots are the smallest vertex of their set, so they come up before the rest of it
+    Components result;
+    result.component.resize(vertexCount);
+    for (int vertex = 0; vertex < vertexCount; ++vertex) {
+        int root = findRoot(parent, vertex);
+        result.component[vertex] = root == vertex ? result.count++ : result.component[root];
+    }
+    return result;
+}
+
+Components StronglyConnectedComponents(const Graph& graph) {
+    const int vertexCount = graph.vertexCount();
+    Components result;
+    result.component.assign(vertexCount, -1);
+
+    // discovery index, -1 until visited, and the lowest index reachable through the DFS subtree
+    std::vector<int> index(vertexCount, -1);
+    std::vector<int> low(vertexCount);
+    // visited vertices not assigned to a component yet; on it means component == -1
+    std::vector<int> open;
+    // the DFS path as (vertex, next edge to look at)
+    std::vector<std::pair<int, int>> path;
+    int nextIndex = 0;
+
+    for (int root = 0; root < vertexCount; ++root) {
+        if (index[root] != -1) continue;
+        index[root] = low[root] = nextIndex++;
+        open.push_back(root);
+        path.push_back({root, graph.offsets[root]});
+
+        while (!path.empty()) {
+            auto& [vertex, edge] = path.back();
+            if (edge < graph.offsets[vertex + 1]) {
+                int target = graph.targets[edge++];
+                if (index[target] == -1) {
+                    index[target] = low[target] = nextIndex++;
+                    open.push_back(target);
+                    path.push_back({target, graph.offsets[target]});
+                } else if (result.component[target] == -1) {
+                    low[vertex] = std::min(low[vertex], index[target]);
+                }
+                continue;
+            }
+
+            // all edges done, vertex heads a component if nothing below it reaches further up
+            int done = vertex;
+            path.pop_back();
+            if (low[done] == index[done]) {
+                int member;
+                do {
+                    member = open.back();
+                    open.pop_back();
+                    result.component[member] = result.count;
+                } while (member != done);
+                ++result.count;
+            }
+            if (!path.empty()) low[path.back().first] = std::min(low[path.back().first], low[done]);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,27 @@
+#ifndef COMPONENTS_HPP
+#define COMPONENTS_HPP
+
+#include <vector>
+
+#include "graph.hpp"
+
+struct Components {
+    // component of every vertex slot, dead slots are components of their own
+    std::vector<int> component;
+    int count = 0;
+};
+
+// Components of the graph with its edges taken as undirected, numbered in the order of their
+// smallest vertex. The edges are merged into a concurrent union-find on threadCount threads (0
+// picks the hardware concurrency) without locks: a root is linked below the smaller root with a
+// compare-and-swap, which fails and retries if another thread linked it first, and finds halve
+// the path with a compare-and-swap per step. Parents only ever decrease, so no thread can make a
+// cycle and a set's root is its smallest vertex.
+Components WeaklyConnectedComponents(const Graph&, int threadCount = 0);
+
+// Tarjan's algorithm with an explicit stack, so long paths don't overflow the call stack.
+// Components are numbered in reverse topological order: edges between components only lead to
+// lower numbers.
+Components StronglyConnectedComponents(const Graph&);
+
+#endif  // COMPONENTS_HPP
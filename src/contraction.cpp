@@ -0,0 +1,413 @@
+#include "contraction.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr double infinity = std::numeric_limits<double>::infinity();
+// a witness search gives up after settling this many vertices and the shortcut is added, which
+// costs an extra edge at worst
+constexpr int witnessSettleLimit = 500;
+
+inline bool hasNegativeWeight(const Graph& graph) {
+    return std::any_of(graph.weights.begin(), graph.weights.end(), [](double w) { return w < 0; });
+}
+
+struct Link {
+    int to;
+    int middle;
+    double weight;
+};
+
+using HeapEntry = std::pair<double, int>;
+
+// the standard heap functions build max-heaps, this orders them by smallest distance
+inline bool laterInHeap(const HeapEntry& lhs, const HeapEntry& rhs) { return lhs > rhs; }
+
+// The graph while it is being contracted: adjacency in both directions over the vertices not
+// contracted yet, at most one arc per ordered pair. Contracting a vertex retires its arcs into
+// upward and downward, they all lead to vertices contracted later.
+class Contractor {
+   public:
+    explicit Contractor(const Graph& graph)
+        : upward(graph.vertexCount()),
+          downward(graph.vertexCount()),
+          out(graph.vertexCount()),
+          in(graph.vertexCount()),
+          contractedNeighbours(graph.vertexCount(), 0),
+          witnessDistance(graph.vertexCount(), infinity),
+          targetStamp(graph.vertexCount(), -1) {
+        for (int from = 0; from < graph.vertexCount(); ++from) {
+            for (int i = graph.offsets[from]; i < graph.offsets[from + 1]; ++i) {
+                int to = graph.targets[i];
+                if (to == from) continue;
+                this->addArc(from, to, graph.isWeighted() ? graph.weights[i] : 1, -1);
+            }
+        }
+    }
+
+    // arcs from a contracted vertex to later ones, and into it from later ones with to as source
+    std::vector<std::vector<Link>> upward;
+    std::vector<std::vector<Link>> downward;
+    int shortcuts = 0;
+
+    // shortcuts added minus arcs removed, plus how many neighbours are gone already so the
+    // contraction spreads over the graph instead of eating one region from the edge
+    int priority(int vertex) {
+        int removed = static_cast<int>(this->in[vertex].size() + this->out[vertex].size());
+        return this->contract(vertex, true) - removed + this->contractedNeighbours[vertex];
+    }
+
+    // returns the shortcuts needed, only adds them unless simulate
+    int contract(int vertex, bool simulate) {
+        int needed = 0;
+        for (size_t i = 0; i < this->in[vertex].size(); ++i) {
+            // copied, adding shortcuts may grow other lists but never this vertex's
+            const Link incoming = this->in[vertex][i];
+            const int from = incoming.to;
+
+            double limit = -infinity;
+            int targets = 0;
+            ++this->searchCount;
+            for (const Link& outgoing : this->out[vertex]) {
+                if (outgoing.to == from) continue;
+                limit = std::max(limit, incoming.weight + outgoing.weight);
+                this->targetStamp[outgoing.to] = this->searchCount;
+                ++targets;
+            }
+            if (targets == 0) continue;
+
+            this->witnessSearch(from, vertex, limit, targets);
+            for (const Link& outgoing : this->out[vertex]) {
+                if (outgoing.to == from) continue;
+                double via = incoming.weight + outgoing.weight;
+                if (this->witnessDistance[outgoing.to] <= via) continue;
+
+                ++needed;
+                if (!simulate) this->addArc(from, outgoing.to, via, vertex);
+            }
+            this->clearWitness();
+        }
+        if (simulate) return needed;
+
+        for (const Link& arc : this->out[vertex]) {
+            this->removeArc(this->in[arc.to], vertex);
+            ++this->contractedNeighbours[arc.to];
+        }
+        for (const Link& arc : this->in[vertex]) {
+            this->removeArc(this->out[arc.to], vertex);
+            ++this->contractedNeighbours[arc.to];
+        }
+        this->upward[vertex] = std::move(this->out[vertex]);
+        this->downward[vertex] = std::move(this->in[vertex]);
+        this->out[vertex] = {};
+        this->in[vertex] = {};
+        return needed;
+    }
+
+   private:
+    std::vector<std::vector<Link>> out;
+    std::vector<std::vector<Link>> in;
+    std::vector<int> contractedNeighbours;
+
+    std::vector<double> witnessDistance;
+    std::vector<int> witnessTouched;
+    std::vector<HeapEntry> witnessHeap;
+    // the vertices a witness search still has to reach carry the search's number
+    std::vector<int> targetStamp;
+    int searchCount = 0;
+
+    // keeps the lighter of two arcs between the same vertices
+    void addArc(int from, int to, double weight, int middle) {
+        for (Link& arc : this->out[from]) {
+            if (arc.to != to) continue;
+            if (weight < arc.weight) {
+                arc = {to, middle, weight};
+                for (Link& reverse : this->in[to])
+                    if (reverse.to == from) reverse = {from, middle, weight};
+            }
+            return;
+        }
+        this->out[from].push_back({to, middle, weight});
+        this->in[to].push_back({from, middle, weight});
+        if (middle != -1) ++this->shortcuts;
+    }
+
+    static void removeArc(std::vector<Link>& arcs, int to) {
+        for (Link& arc : arcs) {
+            if (arc.to != to) continue;
+            arc = arcs.back();
+            arcs.pop_back();
+            return;
+        }
+    }
+
+    // Dijkstra from source over the remaining graph without excluded, up to limit or until all
+    // targets are settled
+    void witnessSearch(int source, int excluded, double limit, int targets) {
+        this->witnessDistance[source] = 0;
+        this->witnessTouched.push_back(source);
+        this->witnessHeap.push_back({0, source});
+
+        int settled = 0;
+        while (!this->witnessHeap.empty() && settled < witnessSettleLimit) {
+            std::pop_heap(this->witnessHeap.begin(), this->witnessHeap.end(), laterInHeap);
+            auto [distance, vertex] = this->witnessHeap.back();
+            this->witnessHeap.pop_back();
+            if (distance > this->witnessDistance[vertex]) continue;
+            if (distance > limit) break;
+            ++settled;
+            if (this->targetStamp[vertex] == this->searchCount && --targets == 0) break;
+
+            for (const Link& arc : this->out[vertex]) {
+                if (arc.to == excluded) continue;
+                double next = distance + arc.weight;
+                if (next >= this->witnessDistance[arc.to]) continue;
+                if (this->witnessDistance[arc.to] == infinity)
+                    this->witnessTouched.push_back(arc.to);
+                this->witnessDistance[arc.to] = next;
+                this->witnessHeap.push_back({next, arc.to});
+                std::push_heap(this->witnessHeap.begin(), this->witnessHeap.end(), laterInHeap);
+            }
+        }
+    }
+
+    void clearWitness() {
+        for (int vertex : this->witnessTouched) this->witnessDistance[vertex] = infinity;
+        this->witnessTouched.clear();
+        this->witnessHeap.clear();
+    }
+};
+
+}  // namespace
+
+std::optional<ContractionHierarchy> ContractionHierarchy::build(const Graph& graph,
+                                                                const std::atomic<bool>* cancel) {
+    if (hasNegativeWeight(graph)) return std::nullopt;
+    const int vertexCount = graph.vertexCount();
+    Contractor contractor(graph);
+
+    // lazy updates: a vertex's priority is only recomputed when it comes up, and it goes back
+    // into the queue if it has become worse than the next one
+    std::vector<std::pair<int, int>> queue;
+    queue.reserve(vertexCount);
+    for (int vertex = 0; vertex < vertexCount; ++vertex) {
+        if (cancel != nullptr && cancel->load()) return std::nullopt;
+        queue.push_back({contractor.priority(vertex), vertex});
+    }
+    std::make_heap(queue.begin(), queue.end(), std::greater<>());
+
+    ContractionHierarchy hierarchy;
+    hierarchy.rank.assign(vertexCount, -1);
+    int nextRank = 0;
+    while (!queue.empty()) {
+        if (cancel != nullptr && cancel->load()) return std::nullopt;
+
+        std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+        int vertex = queue.back().second;
+        queue.pop_back();
+
+        int priority = contractor.priority(vertex);
+        if (!queue.empty() && priority > queue.front().first) {
+            queue.push_back({priority, vertex});
+            std::push_heap(queue.begin(), queue.end(), std::greater<>());
+            continue;
+        }
+
+        contractor.contract(vertex, false);
+        hierarchy.rank[vertex] = nextRank++;
+    }
+
+    hierarchy.forwardOffsets.assign(vertexCount + 1, 0);
+    hierarchy.backwardOffsets.assign(vertexCount + 1, 0);
+    for (int vertex = 0; vertex < vertexCount; ++vertex) {
+        hierarchy.forwardOffsets[vertex + 1] =
+            hierarchy.forwardOffsets[vertex] + static_cast<int>(contractor.upward[vertex].size());
+        hierarchy.backwardOffsets[vertex + 1] = hierarchy.backwardOffsets[vertex] +
+                                                static_cast<int>(contractor.downward[vertex].size());
+    }
+    hierarchy.forwardArcs.reserve(hierarchy.forwardOffsets.back());
+    hierarchy.backwardArcs.reserve(hierarchy.backwardOffsets.back());
+    for (int vertex = 0; vertex < vertexCount; ++vertex) {
+        for (const Link& arc : contractor.upward[vertex])
+            hierarchy.forwardArcs.push_back({arc.to, arc.middle, arc.weight});
+        for (const Link& arc : contractor.downward[vertex])
+            hierarchy.backwardArcs.push_back({arc.to, arc.middle, arc.weight});
+    }
+
+    hierarchy.graphVersion = graph.version;
+    hierarchy.shortcuts = contractor.shortcuts;
+    return hierarchy;
+}
+
+HierarchyQuery::HierarchyQuery(const ContractionHierarchy& hierarchy) : hierarchy(&hierarchy) {
+    for (Side* side : {&this->forward, &this->backward}) {
+        side->distance.assign(hierarchy.vertexCount(), infinity);
+        side->parentArc.assign(hierarchy.vertexCount(), -1);
+        side->parent.assign(hierarchy.vertexCount(), -1);
+    }
+}
+
+void HierarchyQuery::reset(Side& side) {
+    for (int vertex : side.touched) {
+        side.distance[vertex] = infinity;
+        side.parentArc[vertex] = -1;
+        side.parent[vertex] = -1;
+    }
+    side.touched.clear();
+    side.heap.clear();
+}
+
+HierarchyPath HierarchyQuery::shortestPath(int source, int target, bool withPath) {
+    HierarchyPath result;
+    const ContractionHierarchy& hierarchy = *this->hierarchy;
+    if (source < 0 || source >= hierarchy.vertexCount() || target < 0 ||
+        target >= hierarchy.vertexCount())
+        return result;
+
+    this->reset(this->forward);
+    this->reset(this->backward);
+    this->forward.distance[source] = 0;
+    this->forward.touched.push_back(source);
+    this->forward.heap.push_back({0, source});
+    this->backward.distance[target] = 0;
+    this->backward.touched.push_back(target);
+    this->backward.heap.push_back({0, target});
+
+    int meeting = -1;
+    // each side stops once nothing on its queue can improve on the best meeting point
+    auto settle = [&](Side& side, Side& other, const std::vector<int>& offsets,
+                      const std::vector<ContractionHierarchy::Arc>& arcs) {
+        std::pop_heap(side.heap.begin(), side.heap.end(), laterInHeap);
+        auto [distance, vertex] = side.heap.back();
+        side.heap.pop_back();
+        if (distance > side.distance[vertex]) return;
+        ++result.settled;
+
+        if (distance + other.distance[vertex] < result.distance) {
+            result.distance = distance + other.distance[vertex];
+            meeting = vertex;
+        }
+
+        for (int i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            const ContractionHierarchy::Arc& arc = arcs[i];
+            double next = distance + arc.weight;
+            if (next >= side.distance[arc.to]) continue;
+            if (side.distance[arc.to] == infinity) side.touched.push_back(arc.to);
+            side.distance[arc.to] = next;
+            side.parentArc[arc.to] = i;
+            side.parent[arc.to] = vertex;
+            side.heap.push_back({next, arc.to});
+            std::push_heap(side.heap.begin(), side.heap.end(), laterInHeap);
+        }
+    };
+
+    for (;;) {
+        bool forwardOpen =
+            !this->forward.heap.empty() && this->forward.heap.front().first < result.distance;
+        bool backwardOpen =
+            !this->backward.heap.empty() && this->backward.heap.front().first < result.distance;
+        if (!forwardOpen && !backwardOpen) break;
+
+        if (forwardOpen && (!backwardOpen || this->forward.heap.front().first <=
+                                                 this->backward.heap.front().first))
+            settle(this->forward, this->backward, hierarchy.forwardOffsets, hierarchy.forwardArcs);
+        else
+            settle(this->backward, this->forward, hierarchy.backwardOffsets,
+                   hierarchy.backwardArcs);
+    }
+
+    if (meeting == -1 || !withPath) return result;
+
+    // up from the source to the meeting point, then down to the target, shortcuts unpacked
+    std::vector<int> up;
+    for (int vertex = meeting; vertex != source; vertex = this->forward.parent[vertex])
+        up.push_back(vertex);
+    result.path.push_back(source);
+    for (auto vertex = up.rbegin(); vertex != up.rend(); ++vertex) {
+        int from = this->forward.parent[*vertex];
+        this->unpack(from, *vertex,
+                     hierarchy.forwardArcs[this->forward.parentArc[*vertex]].middle, result.path);
+    }
+    for (int vertex = meeting; vertex != target; vertex = this->backward.parent[vertex]) {
+        int to = this->backward.parent[vertex];
+        this->unpack(vertex, to, hierarchy.backwardArcs[this->backward.parentArc[vertex]].middle,
+                     result.path);
+    }
+    return result;
+}
+
+void HierarchyQuery::unpack(int from, int to, int middle, std::vector<int>& path) const {
+    const ContractionHierarchy& hierarchy = *this->hierarchy;
+    // (from, to, middle) still to expand, the next one on top; shortcuts can nest deeply
+    std::vector<std::tuple<int, int, int>> stack{{from, to, middle}};
+    while (!stack.empty()) {
+        auto [a, b, m] = stack.back();
+        stack.pop_back();
+        if (m == -1) {
+            path.push_back(b);
+            continue;
+        }
+
+        // m was contracted before both ends, so a -> m is stored backward at m and m -> b
+        // forward at m
+        int first = -1, second = -1;
+        for (int i = hierarchy.backwardOffsets[m]; i < hierarchy.backwardOffsets[m + 1]; ++i)
+            if (hierarchy.backwardArcs[i].to == a) first = hierarchy.backwardArcs[i].middle;
+        for (int i = hierarchy.forwardOffsets[m]; i < hierarchy.forwardOffsets[m + 1]; ++i)
+            if (hierarchy.forwardArcs[i].to == b) second = hierarchy.forwardArcs[i].middle;
+        stack.push_back({m, b, second});
+        stack.push_back({a, m, first});
+    }
+}
+
+HierarchyBuilder::HierarchyBuilder() : results(std::make_shared<Results>()) {}
+
+HierarchyBuilder::~HierarchyBuilder() { this->stop(); }
+
+bool HierarchyBuilder::rebuild(Graph graph) {
+    this->stop();
+    this->requestedVersion = graph.version;
+    // build() would refuse it too, this way no thread is started for nothing
+    if (hasNegativeWeight(graph)) return false;
+
+    auto build = std::make_shared<Build>();
+    this->latest = build;
+    std::thread([build, results = this->results, sequence = ++this->rebuilds,
+                 graph = std::move(graph)] {
+        auto built = ContractionHierarchy::build(graph, &build->cancelled);
+        if (built.has_value()) {
+            auto finished = std::make_shared<const ContractionHierarchy>(std::move(*built));
+            std::lock_guard lock(results->mutex);
+            if (sequence > results->sequence) {
+                results->newest = std::move(finished);
+                results->sequence = sequence;
+            }
+        }
+        build->done = true;
+    }).detach();
+    return true;
+}
+
+void HierarchyBuilder::stop() {
+    if (this->latest != nullptr) this->latest->cancelled = true;
+    this->latest.reset();
+}
+
+bool HierarchyBuilder::building() const {
+    return this->latest != nullptr && !this->latest->done.load();
+}
+
+std::shared_ptr<const ContractionHierarchy> HierarchyBuilder::current() const {
+    std::lock_guard lock(this->results->mutex);
+    return this->results->newest;
+}
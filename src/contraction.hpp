@@ -0,0 +1,141 @@
+#ifndef CONTRACTION_HPP
+#define CONTRACTION_HPP
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "graph.hpp"
+
+// Contraction hierarchy over a weighted graph, for point-to-point shortest paths that settle a
+// few hundred vertices instead of everything closer than the target. Vertices are contracted one
+// at a time, least important first (the fewest shortcuts added for the edges removed): every
+// shortest path through the contracted vertex between two remaining neighbours is replaced by a
+// shortcut edge, unless a bounded witness search finds a path that is no longer without it. The
+// rank is the contraction order. A shortest path then always climbs to its highest ranked vertex
+// and descends again, so a query only searches upwards, forwards from the source and backwards
+// from the target. Unweighted graphs weigh 1 per edge like Dijkstra, weights must not be
+// negative.
+class ContractionHierarchy {
+   public:
+    // nullopt when a weight is negative or cancel was set during the build
+    static std::optional<ContractionHierarchy> build(const Graph&,
+                                                     const std::atomic<bool>* cancel = nullptr);
+
+    inline int vertexCount() const { return static_cast<int>(this->rank.size()); }
+    // version of the graph it was built from
+    inline unsigned long version() const { return this->graphVersion; }
+    // shortcuts added on top of the graph's edges
+    inline int shortcutCount() const { return this->shortcuts; }
+
+   private:
+    friend class HierarchyQuery;
+
+    // an original edge when middle is -1, otherwise a shortcut for the path through middle
+    struct Arc {
+        int to;
+        int middle;
+        double weight;
+    };
+
+    std::vector<int> rank;
+    // arcs to higher ranked vertices, forwardArcs[forwardOffsets[v] ..] for v
+    std::vector<int> forwardOffsets;
+    std::vector<Arc> forwardArcs;
+    // arcs from higher ranked vertices into v, to is where they come from
+    std::vector<int> backwardOffsets;
+    std::vector<Arc> backwardArcs;
+    unsigned long graphVersion = 0;
+    int shortcuts = 0;
+};
+
+struct HierarchyPath {
+    // infinity when the target can't be reached
+    double distance = std::numeric_limits<double>::infinity();
+    // source to target over original edges, empty when the target can't be reached
+    std::vector<int> path;
+    // vertices settled by both searches together
+    int settled = 0;
+};
+
+// Bidirectional upward search on a hierarchy. It keeps its distance arrays between queries and
+// only resets what the last one touched, so a query costs what it settles. One per thread, the
+// hierarchy has to outlive it.
+class HierarchyQuery {
+   public:
+    explicit HierarchyQuery(const ContractionHierarchy&);
+
+    // the path is unpacked into original edges only when withPath is set
+    HierarchyPath shortestPath(int source, int target, bool withPath = true);
+
+   private:
+    struct Side {
+        std::vector<double> distance;
+        // arc index the vertex was reached over, -1 for the start
+        std::vector<int> parentArc;
+        std::vector<int> parent;
+        std::vector<int> touched;
+        // (distance, vertex) min-heap
+        std::vector<std::pair<double, int>> heap;
+    };
+
+    const ContractionHierarchy* hierarchy;
+    Side forward;
+    Side backward;
+
+    void reset(Side& side);
+    void unpack(int from, int to, int middle, std::vector<int>& path) const;
+};
+
+// Rebuilds a hierarchy on a background thread whenever asked to, so edits never wait for it.
+// Builds run on detached threads: a superseded one is cancelled and left to notice on its own,
+// nobody joins it. Finished hierarchies are handed out as shared pointers, a reader keeps using
+// the one it holds while the next is built.
+class HierarchyBuilder {
+   public:
+    HierarchyBuilder();
+    ~HierarchyBuilder();
+
+    HierarchyBuilder(const HierarchyBuilder&) = delete;
+    HierarchyBuilder& operator=(const HierarchyBuilder&) = delete;
+
+    // Cancels a build still running for an older graph and starts one for this graph. False,
+    // without starting anything, when a weight is negative.
+    bool rebuild(Graph graph);
+    // cancels the build in progress
+    void stop();
+
+    bool building() const;
+    // version of the graph the last rebuild was asked for
+    inline unsigned long version() const { return this->requestedVersion; }
+
+    // the newest finished hierarchy, nullptr before the first; it may be for an older graph,
+    // compare its version()
+    std::shared_ptr<const ContractionHierarchy> current() const;
+
+   private:
+    // one per rebuild, shared with its thread
+    struct Build {
+        std::atomic<bool> cancelled = false;
+        std::atomic<bool> done = false;
+    };
+    // outlives the builder as long as a detached build still holds it
+    struct Results {
+        std::mutex mutex;
+        std::shared_ptr<const ContractionHierarchy> newest;
+        // rebuild number of newest, a build that finishes late doesn't replace a later one
+        unsigned long sequence = 0;
+    };
+
+    unsigned long requestedVersion = 0;
+    unsigned long rebuilds = 0;
+    std::shared_ptr<Build> latest;
+    std::shared_ptr<Results> results;
+};
+
+#endif  // CONTRACTION_HPP
@@ -1,16 +1,18 @@
 #include "edge.hpp"
 
-#include <string>
+#include "weight.hpp"
 
 int Edge::instanceCounter = 0;
 
+Edge::Edge() : id(-1), fromId(-1), toId(-1) {}
+
 Edge::Edge(int fromId, int toId) {
     this->id = instanceCounter++;
     this->fromId = fromId;
     this->toId = toId;
 }
 
-Edge::Edge(int fromId, int toId, const std::string& weight) {
+Edge::Edge(int fromId, int toId, const Weight& weight) {
     this->id = instanceCounter++;
     this->fromId = fromId;
     this->toId = toId;
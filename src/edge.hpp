@@ -1,20 +1,22 @@
 #ifndef EDGE_HPP
 #define EDGE_HPP
 
-#include <string>
+#include "weight.hpp"
 
 struct Edge {
     static int instanceCounter;
     int id;
     int fromId;
     int toId;
-    // weight is string to simplify the update process
-    std::string weight;
+    // only meaningful when weighted, text is produced by weight.toString() for display
+    Weight weight;
     bool weighted = false;
     bool usable = true;
 
+    // unnumbered, for bulk loads that fill edges in place and number them themselves
+    Edge();
     Edge(int, int);
-    Edge(int, int, const std::string&);
+    Edge(int, int, const Weight&);
 
     friend bool operator==(const Edge& lhs, const Edge& rhs);
     friend bool operator!=(const Edge& lhs, const Edge& rhs);
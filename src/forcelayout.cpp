@@ -0,0 +1,543 @@
+#include "forcelayout.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+
+namespace {
+
+// relative strength of the repulsion, Hu's default
+constexpr float repulsion = 0.2f;
+// the step shrinks by cooling when the energy goes up and grows again after progressSteps
+// improvements in a row
+constexpr float cooling = 0.9f;
+constexpr int progressSteps = 5;
+// converged once the step is below this fraction of K
+constexpr float tolerance = 0.01f;
+// levels that start from a prolonged layout, and refinement after edits, only need to settle
+constexpr float refineStep = 0.1f;
+constexpr int refineIterations = 50;
+// graphs are coarsened down to about this many vertices, and only while a level merges at least
+// a quarter of them
+constexpr int coarsestSize = 64;
+constexpr double coarseningLimit = 0.75;
+// coincident vertices share a leaf below this depth instead of splitting forever
+constexpr int maxDepth = 40;
+// the published index is built in slices of this many inserts, checking for stop in between
+constexpr size_t publishSlice = 4096;
+
+struct QuadNode {
+    // square cell centred on (x, y) reaching half its width in each direction
+    float x, y, half;
+    // centre of mass of the bodies below
+    float massX = 0, massY = 0;
+    int mass = 0;
+    // first of four children, -1 for leaves
+    int firstChild = -1;
+};
+
+class QuadTree {
+   public:
+    // bodies in depth-first leaf order, so neighbouring entries are close in space. The force
+    // pass walks bodies in this order, which keeps consecutive traversals on the same nodes, and
+    // the next build inserts in it
+    std::vector<int> order;
+
+    void build(const std::vector<Vector2>& positions) {
+        this->nodes.clear();
+        this->bodies.clear();
+        this->sumX.clear();
+        this->sumY.clear();
+        this->leafOf.assign(positions.size(), -1);
+        this->nextInLeaf.assign(positions.size(), -1);
+        if (this->order.size() != positions.size()) {
+            this->order.resize(positions.size());
+            for (size_t body = 0; body < positions.size(); ++body)
+                this->order[body] = static_cast<int>(body);
+        }
+        if (positions.empty()) return;
+
+        float minX = positions[0].x, maxX = minX, minY = positions[0].y, maxY = minY;
+        for (const Vector2& pos : positions) {
+            minX = std::min(minX, pos.x);
+            maxX = std::max(maxX, pos.x);
+            minY = std::min(minY, pos.y);
+            maxY = std::max(maxY, pos.y);
+        }
+        float half = std::max(maxX - minX, maxY - minY) / 2 + 1;
+        this->addNode({(minX + maxX) / 2, (minY + maxY) / 2, half});
+
+        for (int body : this->order) this->insert(positions, body);
+
+        // centres of mass, and the leaf order for the next pass
+        this->order.clear();
+        int stack[4 * maxDepth + 4];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const int index = stack[--top];
+            QuadNode& node = this->nodes[index];
+            if (node.mass == 0) continue;
+            node.massX = static_cast<float>(this->sumX[index] / node.mass);
+            node.massY = static_cast<float>(this->sumY[index] / node.mass);
+            if (node.firstChild >= 0) {
+                for (int child = 3; child >= 0; --child) stack[top++] = node.firstChild + child;
+            } else {
+                for (int body = this->bodies[index]; body != -1; body = this->nextInLeaf[body])
+                    this->order.push_back(body);
+            }
+        }
+    }
+
+    // repulsion on body from every other body, approximating cells that look small from there
+    Vector2 repulse(const std::vector<Vector2>& positions, int body, float strength,
+                    float theta) const {
+        const Vector2 pos = positions[body];
+        const float thetaSquared = theta * theta;
+        float forceX = 0, forceY = 0;
+
+        int stack[4 * maxDepth + 4];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const int index = stack[--top];
+            const QuadNode& node = this->nodes[index];
+            float mass = static_cast<float>(node.mass);
+            float centreX = node.massX, centreY = node.massY;
+            if (index == this->leafOf[body]) {
+                // take the body itself out of its leaf
+                if (node.mass == 1) continue;
+                centreX = (centreX * mass - pos.x) / (mass - 1);
+                centreY = (centreY * mass - pos.y) / (mass - 1);
+                mass -= 1;
+            }
+            if (mass <= 0) continue;
+
+            float dx = pos.x - centreX;
+            float dy = pos.y - centreY;
+            float distanceSquared = dx * dx + dy * dy;
+            float width = 2.0f * node.half;
+
+            if (node.firstChild < 0 || width * width < thetaSquared * distanceSquared) {
+                if (distanceSquared < 1e-6f) {
+                    // stacked on top of each other, push apart in a direction fixed per body
+                    float angle = body * 2.399963f;
+                    forceX += strength * mass * std::cos(angle);
+                    forceY += strength * mass * std::sin(angle);
+                } else {
+                    float scale = strength * mass / distanceSquared;
+                    forceX += dx * scale;
+                    forceY += dy * scale;
+                }
+            } else {
+                for (int child = 0; child < 4; ++child) stack[top++] = node.firstChild + child;
+            }
+        }
+
+        return {forceX, forceY};
+    }
+
+   private:
+    std::vector<QuadNode> nodes;
+    // position sums per node while building, for the centres of mass
+    std::vector<double> sumX, sumY;
+    // first body of each leaf, -1 when empty or internal; bodies sharing a leaf at maxDepth are
+    // chained through nextInLeaf
+    std::vector<int> bodies;
+    std::vector<int> nextInLeaf;
+    // leaf each body ended up in, its own contribution is taken out there
+    std::vector<int> leafOf;
+
+    inline int quadrant(const QuadNode& node, const Vector2& pos) const {
+        return (pos.x >= node.x ? 1 : 0) + (pos.y >= node.y ? 2 : 0);
+    }
+
+    inline void addNode(const QuadNode& node) {
+        this->nodes.push_back(node);
+        this->bodies.push_back(-1);
+        this->sumX.push_back(0);
+        this->sumY.push_back(0);
+    }
+
+    void insert(const std::vector<Vector2>& positions, int body) {
+        const Vector2& pos = positions[body];
+        int index = 0;
+        for (int depth = 0;; ++depth) {
+            this->sumX[index] += pos.x;
+            this->sumY[index] += pos.y;
+            QuadNode& node = this->nodes[index];
+            ++node.mass;
+
+            if (node.firstChild >= 0) {
+                index = node.firstChild + this->quadrant(node, pos);
+                continue;
+            }
+            if (node.mass == 1 || depth >= maxDepth) {
+                this->nextInLeaf[body] = this->bodies[index];
+                this->bodies[index] = body;
+                this->leafOf[body] = index;
+                return;
+            }
+
+            // split the leaf and move its body down before going on with this one
+            const float x = node.x, y = node.y, quarter = node.half / 2;
+            const int first = static_cast<int>(this->nodes.size());
+            node.firstChild = first;
+            for (int child = 0; child < 4; ++child)
+                this->addNode({x + (child & 1 ? quarter : -quarter),
+                               y + (child & 2 ? quarter : -quarter), quarter});
+
+            int resident = this->bodies[index];
+            this->bodies[index] = -1;
+            int residentChild = first + this->quadrant(this->nodes[index], positions[resident]);
+            this->nodes[residentChild].mass = 1;
+            this->sumX[residentChild] = positions[resident].x;
+            this->sumY[residentChild] = positions[resident].y;
+            this->bodies[residentChild] = resident;
+            this->leafOf[resident] = residentChild;
+
+            index = first + this->quadrant(this->nodes[index], pos);
+        }
+    }
+};
+
+// one graph of the multilevel hierarchy, level 0 is the graph itself
+struct Level {
+    // undirected adjacency
+    std::vector<int> offsets;
+    std::vector<int> neighbours;
+    // vertex of the next coarser level each vertex was merged into
+    std::vector<int> parent;
+
+    inline int vertexCount() const { return static_cast<int>(this->offsets.size()) - 1; }
+    inline int degree(int v) const { return this->offsets[v + 1] - this->offsets[v]; }
+};
+
+// Merges a maximal matching of fine, visiting vertices in a fixed shuffled order and pairing
+// each with its unmatched neighbour of lowest degree. Fills fine.parent; false when too few vertices merge to be worth a
+// level, as on star-like graphs.
+bool coarsen(Level& fine, Level& coarse) {
+    const int count = fine.vertexCount();
+    std::vector<int> order(count);
+    for (int v = 0; v < count; ++v) order[v] = v;
+    std::shuffle(order.begin(), order.end(), std::mt19937(count));
+
+    std::vector<int> parent(count, -1);
+    int coarseCount = 0;
+    for (int v : order) {
+        if (parent[v] != -1) continue;
+        int partner = -1;
+        for (int i = fine.offsets[v]; i < fine.offsets[v + 1]; ++i) {
+            int u = fine.neighbours[i];
+            if (u != v && parent[u] == -1 &&
+                (partner == -1 || fine.degree(u) < fine.degree(partner)))
+                partner = u;
+        }
+        parent[v] = coarseCount;
+        if (partner != -1) parent[partner] = coarseCount;
+        ++coarseCount;
+    }
+    if (coarseCount > count * coarseningLimit) return false;
+
+    // rows of merged vertices are concatenated, then sorted to drop repeats and self loops
+    coarse.offsets.assign(coarseCount + 1, 0);
+    for (int v = 0; v < count; ++v) coarse.offsets[parent[v] + 1] += fine.degree(v);
+    for (int c = 0; c < coarseCount; ++c) coarse.offsets[c + 1] += coarse.offsets[c];
+    coarse.neighbours.resize(coarse.offsets[coarseCount]);
+    std::vector<int> cursor(coarse.offsets.begin(), coarse.offsets.end() - 1);
+    for (int v = 0; v < count; ++v)
+        for (int i = fine.offsets[v]; i < fine.offsets[v + 1]; ++i)
+            coarse.neighbours[cursor[parent[v]]++] = parent[fine.neighbours[i]];
+
+    int kept = 0;
+    for (int c = 0; c < coarseCount; ++c) {
+        auto first = coarse.neighbours.begin() + coarse.offsets[c];
+        auto last = coarse.neighbours.begin() + coarse.offsets[c + 1];
+        std::sort(first, last);
+        int rowStart = kept;
+        for (auto it = first; it != last; ++it)
+            if (*it != c && (kept == rowStart || coarse.neighbours[kept - 1] != *it))
+                coarse.neighbours[kept++] = *it;
+        coarse.offsets[c] = rowStart;
+    }
+    coarse.offsets[coarseCount] = kept;
+    coarse.neighbours.resize(kept);
+
+    fine.parent = std::move(parent);
+    return true;
+}
+
+}  // namespace
+
+ForceLayout::ForceLayout(const LayoutOptions& options) : options(options) {}
+
+ForceLayout::~ForceLayout() { this->stop(); }
+
+void ForceLayout::start(const GraphStore& store, bool refine) {
+    this->stop();
+
+    Problem problem;
+    const std::vector<Vertex>& vertices = store.vertices();
+    std::vector<int> indexOf(vertices.size(), -1);
+    problem.slotPositions.reserve(vertices.size());
+    for (const Vertex& vertex : vertices) {
+        problem.slotPositions.push_back(vertex.pos);
+        if (!vertex.usable) continue;
+        indexOf[vertex.id] = static_cast<int>(problem.slots.size());
+        problem.slots.push_back(vertex.id);
+        problem.positions.push_back(vertex.pos);
+        problem.radii.push_back(vertex.radius);
+    }
+
+    const int count = static_cast<int>(problem.slots.size());
+    problem.offsets.assign(count + 1, 0);
+    for (const Edge& edge : store.edges()) {
+        int from = indexOf[edge.fromId], to = indexOf[edge.toId];
+        if (from < 0 || to < 0) continue;
+        problem.edgeIds.push_back(edge.id);
+        problem.edgeFrom.push_back(from);
+        problem.edgeTo.push_back(to);
+        ++problem.offsets[from + 1];
+        ++problem.offsets[to + 1];
+    }
+    for (int v = 0; v < count; ++v) problem.offsets[v + 1] += problem.offsets[v];
+
+    problem.neighbours.resize(problem.offsets[count]);
+    std::vector<int> cursor(problem.offsets.begin(), problem.offsets.end() - 1);
+    for (size_t e = 0; e < problem.edgeIds.size(); ++e) {
+        problem.neighbours[cursor[problem.edgeFrom[e]]++] = problem.edgeTo[e];
+        problem.neighbours[cursor[problem.edgeTo[e]]++] = problem.edgeFrom[e];
+    }
+
+    this->startedVersion = store.topologyVersion();
+    this->iterationCount = 0;
+    this->active = true;
+    this->worker = std::thread(&ForceLayout::run, this, std::move(problem), refine);
+}
+
+void ForceLayout::stop() {
+    this->stopping = true;
+    this->wait();
+    this->stopping = false;
+
+    std::lock_guard lock(this->snapshotMutex);
+    this->snapshot.positions.clear();
+    this->snapshot.index.clear();
+    this->snapshot.fresh = false;
+}
+
+void ForceLayout::wait() {
+    if (this->worker.joinable()) this->worker.join();
+}
+
+bool ForceLayout::apply(GraphStore& store) {
+    std::unique_lock lock(this->snapshotMutex, std::try_to_lock);
+    if (!lock.owns_lock() || !this->snapshot.fresh) return false;
+    this->snapshot.fresh = false;
+    if (store.topologyVersion() != this->startedVersion) return false;
+
+    // the store's old index comes back and is freed by the worker on its next publish
+    store.setLayout(this->snapshot.positions, this->snapshot.index);
+    return true;
+}
+
+void ForceLayout::run(Problem problem, bool refine) {
+    const int threadCount = resolveThreadCount(this->options.threadCount);
+    // pairs settle where C K^2 / d = d^2 / K, so K is scaled to put that at edgeLength
+    const float k = this->options.edgeLength / std::cbrt(repulsion);
+    const float strength = repulsion * k * k;
+    const float theta = this->options.theta;
+
+    // a full layout starts on the coarsest graph and works its way back, which avoids most of
+    // the folds a single level gets stuck in and needs far fewer iterations on the full graph;
+    // refining stays on the graph itself
+    std::vector<Level> levels(1);
+    levels[0].offsets = std::move(problem.offsets);
+    levels[0].neighbours = std::move(problem.neighbours);
+    if (!refine) {
+        while (levels.back().vertexCount() > coarsestSize) {
+            Level coarse;
+            if (!coarsen(levels.back(), coarse)) break;
+            levels.push_back(std::move(coarse));
+        }
+    }
+
+    // coarse vertices start at the centroid of what they stand for
+    std::vector<std::vector<Vector2>> startPositions(levels.size());
+    startPositions[0] = problem.positions;
+    for (size_t l = 1; l < levels.size(); ++l) {
+        const Level& fine = levels[l - 1];
+        std::vector<Vector2>& coarse = startPositions[l];
+        std::vector<int> members(levels[l].vertexCount(), 0);
+        coarse.assign(levels[l].vertexCount(), {0, 0});
+        for (int v = 0; v < fine.vertexCount(); ++v) {
+            coarse[fine.parent[v]].x += startPositions[l - 1][v].x;
+            coarse[fine.parent[v]].y += startPositions[l - 1][v].y;
+            ++members[fine.parent[v]];
+        }
+        for (size_t c = 0; c < coarse.size(); ++c) {
+            coarse[c].x /= members[c];
+            coarse[c].y /= members[c];
+        }
+    }
+
+    std::vector<Vector2> positions = std::move(startPositions.back());
+    startPositions.clear();
+    std::vector<Vector2> next;
+    std::vector<double> threadEnergy(threadCount);
+    QuadTree tree;
+    auto lastPublish = std::chrono::steady_clock::now();
+    double publishCost = 0;
+
+    for (int level = static_cast<int>(levels.size()) - 1; level >= 0; --level) {
+        const Level& graph = levels[level];
+        const int count = graph.vertexCount();
+
+        if (level + 1 < static_cast<int>(levels.size())) {
+            // the finer graph needs more room, spread the coarse layout around its centroid and
+            // nudge merged pairs apart
+            float centreX = 0, centreY = 0;
+            for (const Vector2& pos : positions) {
+                centreX += pos.x / positions.size();
+                centreY += pos.y / positions.size();
+            }
+            const float scale = std::sqrt(static_cast<float>(count) / positions.size());
+            std::vector<Vector2> fine(count);
+            for (int v = 0; v < count; ++v) {
+                const Vector2& pos = positions[graph.parent[v]];
+                float angle = v * 2.399963f;
+                fine[v] = {centreX + (pos.x - centreX) * scale + 0.05f * k * std::cos(angle),
+                           centreY + (pos.y - centreY) * scale + 0.05f * k * std::sin(angle)};
+            }
+            positions.swap(fine);
+        }
+
+        // level 0 vertex -> vertex of this level, for publishing previews from coarse levels
+        std::vector<int> ancestor;
+        if (level > 0) {
+            ancestor.resize(levels[0].vertexCount());
+            for (int v = 0; v < levels[0].vertexCount(); ++v) {
+                int a = v;
+                for (int l = 0; l < level; ++l) a = levels[l].parent[a];
+                ancestor[v] = a;
+            }
+        }
+        auto publishLevel = [&] {
+            if (level == 0) {
+                problem.positions = positions;
+            } else {
+                for (size_t v = 0; v < ancestor.size(); ++v)
+                    problem.positions[v] = positions[ancestor[v]];
+            }
+            return this->publish(problem);
+        };
+
+        next.resize(count);
+        const bool coarsest = level == static_cast<int>(levels.size()) - 1;
+        float step = coarsest && !refine ? k : refineStep * k;
+        double energy = std::numeric_limits<double>::infinity();
+        int progress = 0;
+
+        const int iterationLimit =
+            coarsest && !refine ? this->options.maxIterations
+                                : std::min(this->options.maxIterations, refineIterations);
+        for (int iteration = 0; iteration < iterationLimit && count > 1; ++iteration) {
+            if (this->stopping) break;
+
+            tree.build(positions);
+            runThreads(threadCount, [&](int t) {
+                const int first = static_cast<int>(static_cast<long>(count) * t / threadCount);
+                const int last =
+                    static_cast<int>(static_cast<long>(count) * (t + 1) / threadCount);
+                double partialEnergy = 0;
+
+                for (int i = first; i < last; ++i) {
+                    const int v = tree.order[i];
+                    const Vector2 pos = positions[v];
+                    Vector2 force = tree.repulse(positions, v, strength, theta);
+                    for (int i = graph.offsets[v]; i < graph.offsets[v + 1]; ++i) {
+                        const Vector2 other = positions[graph.neighbours[i]];
+                        float dx = other.x - pos.x, dy = other.y - pos.y;
+                        float distance = std::sqrt(dx * dx + dy * dy);
+                        force.x += dx * distance / k;
+                        force.y += dy * distance / k;
+                    }
+
+                    float magnitudeSquared = force.x * force.x + force.y * force.y;
+                    partialEnergy += magnitudeSquared;
+                    if (magnitudeSquared > 0) {
+                        float scale = step / std::sqrt(magnitudeSquared);
+                        next[v] = {pos.x + force.x * scale, pos.y + force.y * scale};
+                    } else {
+                        next[v] = pos;
+                    }
+                }
+                threadEnergy[t] = partialEnergy;
+            });
+            positions.swap(next);
+            ++this->iterationCount;
+
+            double newEnergy = 0;
+            for (double partial : threadEnergy) newEnergy += partial;
+            if (newEnergy < energy) {
+                if (++progress >= progressSteps) {
+                    progress = 0;
+                    step /= cooling;
+                }
+            } else {
+                progress = 0;
+                step *= cooling;
+            }
+            energy = newEnergy;
+            if (step < tolerance * k) break;
+
+            // building the snapshot's index is O(n + m) as well, publishing is spaced out so it
+            // never takes more than a fifth of the time
+            auto now = std::chrono::steady_clock::now();
+            if (std::chrono::duration<double>(now - lastPublish).count() >=
+                std::max(this->options.publishInterval, 4 * publishCost)) {
+                if (!publishLevel()) break;
+                lastPublish = std::chrono::steady_clock::now();
+                publishCost = std::chrono::duration<double>(lastPublish - now).count();
+            }
+        }
+        if (this->stopping) break;
+        if (level == 0) publishLevel();
+    }
+
+    this->active = false;
+}
+
+bool ForceLayout::publish(Problem& problem) {
+    std::vector<Vector2> positions = problem.slotPositions;
+    for (size_t i = 0; i < problem.slots.size(); ++i)
+        positions[problem.slots[i]] = problem.positions[i];
+
+    // same index the store would build by moving every vertex, but built here off the render
+    // thread
+    SpatialIndex index;
+    for (size_t i = 0; i < problem.slots.size(); ++i) {
+        if (i % publishSlice == 0 && this->stopping) return false;
+        index.insertVertex(problem.slots[i], problem.positions[i], problem.radii[i]);
+    }
+    for (size_t e = 0; e < problem.edgeIds.size(); ++e) {
+        if (e % publishSlice == 0 && this->stopping) return false;
+        index.insertEdge(problem.edgeIds[e], problem.positions[problem.edgeFrom[e]],
+                         problem.positions[problem.edgeTo[e]]);
+    }
+
+    {
+        std::lock_guard lock(this->snapshotMutex);
+        this->snapshot.positions.swap(positions);
+        std::swap(this->snapshot.index, index);
+        this->snapshot.fresh = true;
+    }
+    // index now holds the previous snapshot's or the store's old index, freed outside the lock
+    return true;
+}
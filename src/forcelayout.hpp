@@ -0,0 +1,102 @@
+#ifndef FORCELAYOUT_HPP
+#define FORCELAYOUT_HPP
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "graphstore.hpp"
+#include "spatialindex.hpp"
+#include "types.hpp"
+
+struct LayoutOptions {
+    int threadCount = 0;  // 0 picks the hardware concurrency
+    // distance two connected vertices settle at when nothing else pulls on them
+    float edgeLength = 70.0f;
+    // Barnes-Hut opening criterion, a quadtree cell narrower than theta times its distance acts
+    // as a single body
+    float theta = 1.2f;
+    // for the coarsest graph, the finer levels and refinement stop after far fewer
+    int maxIterations = 1000;
+    // seconds between published snapshots while iterating, the final one is always published
+    double publishInterval = 0.25;
+};
+
+// Spring-electrical layout after Hu, "Efficient and high quality force-directed graph drawing"
+// (2005): edges pull with d^2 / K, every pair of vertices pushes apart with C K^2 / d, each vertex
+// moves one step along its force and the step adapts to whether the energy still drops. The
+// repulsion is approximated with a Barnes-Hut quadtree rebuilt every iteration, so an iteration
+// is O(n log n + m) and the force pass is split over threadCount threads. A full layout is
+// multilevel: the graph is coarsened by merging matched neighbours until it is small, the
+// coarsest graph is laid out first and every finer one starts from the layout above it.
+//
+// start() copies what the layout needs out of the store and iterates on a background thread.
+// Snapshots of the positions are published together with a spatial index already built over
+// them, so apply() on the render thread is a copy of the positions and an index swap, never a
+// wait: the snapshot lock is only tried. Edges are treated as undirected and unusable vertices
+// are left where they are.
+class ForceLayout {
+   public:
+    explicit ForceLayout(const LayoutOptions& options = {});
+    ~ForceLayout();
+
+    ForceLayout(const ForceLayout&) = delete;
+    ForceLayout& operator=(const ForceLayout&) = delete;
+
+    // Stops a running layout and starts over from the store's current positions. refine starts
+    // with a small step, which keeps the arrangement and only settles what changed after an edit.
+    void start(const GraphStore&, bool refine = false);
+    void stop();
+    // blocks until the layout has converged or hit maxIterations
+    void wait();
+
+    inline bool running() const { return this->active.load(); }
+    inline int iterations() const { return this->iterationCount.load(); }
+    // store topology version the layout was started from, snapshots only apply to that version
+    inline unsigned long version() const { return this->startedVersion; }
+
+    // Moves the store's vertices to the newest unapplied snapshot. false when there is none,
+    // the worker is publishing at that moment, or the topology was edited since start().
+    bool apply(GraphStore&);
+
+   private:
+    struct Problem {
+        // layout index -> vertex id, only usable vertices take part
+        std::vector<int> slots;
+        std::vector<Vector2> positions;
+        std::vector<float> radii;
+        // undirected adjacency over layout indices
+        std::vector<int> offsets;
+        std::vector<int> neighbours;
+        // usable edges as (id, from, to) in layout indices, for the published index
+        std::vector<int> edgeIds;
+        std::vector<int> edgeFrom;
+        std::vector<int> edgeTo;
+        // positions of every vertex slot, the published array
+        std::vector<Vector2> slotPositions;
+    };
+
+    struct Snapshot {
+        std::vector<Vector2> positions;
+        SpatialIndex index;
+        bool fresh = false;
+    };
+
+    LayoutOptions options;
+    unsigned long startedVersion = 0;
+
+    std::thread worker;
+    std::atomic<bool> stopping = false;
+    std::atomic<bool> active = false;
+    std::atomic<int> iterationCount = 0;
+
+    std::mutex snapshotMutex;
+    Snapshot snapshot;
+
+    void run(Problem problem, bool refine);
+    // false when stopped halfway
+    bool publish(Problem& problem);
+};
+
+#endif  // FORCELAYOUT_HPP
@@ -0,0 +1,107 @@
+#ifndef GRAPH_HPP
+#define GRAPH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+// One array of a CSR graph. It either owns its elements or borrows them from memory that owner
+// keeps alive, like a mapped .gphz file, so a graph can be used straight from the file. Reads
+// look the same either way. Writes go through writable() or the resizing calls, which copy a
+// borrowed array first; copies of a borrowed array share the borrowed memory.
+template <typename T>
+class CsrArray {
+   public:
+    CsrArray() = default;
+    CsrArray(std::initializer_list<T> values) : owned(values), view(this->owned) {}
+    CsrArray(std::span<const T> elements, std::shared_ptr<const void> owner)
+        : view(elements), owner(std::move(owner)) {}
+
+    CsrArray(const CsrArray& other)
+        : owned(other.owned),
+          view(other.owner ? other.view : std::span<const T>(this->owned)),
+          owner(other.owner) {}
+    CsrArray(CsrArray&& other) noexcept
+        : owned(std::move(other.owned)), view(other.view), owner(std::move(other.owner)) {
+        other.view = {};
+    }
+    CsrArray& operator=(const CsrArray& other) {
+        if (this != &other) *this = CsrArray(other);
+        return *this;
+    }
+    CsrArray& operator=(CsrArray&& other) noexcept {
+        this->owned = std::move(other.owned);
+        this->view = std::exchange(other.view, {});
+        this->owner = std::move(other.owner);
+        return *this;
+    }
+
+    inline std::size_t size() const { return this->view.size(); }
+    inline bool empty() const { return this->view.empty(); }
+    inline const T& operator[](std::size_t i) const { return this->view[i]; }
+    inline const T* data() const { return this->view.data(); }
+    inline const T* begin() const { return this->view.data(); }
+    inline const T* end() const { return this->view.data() + this->view.size(); }
+    inline const T& front() const { return this->view.front(); }
+    inline const T& back() const { return this->view.back(); }
+    inline bool borrowed() const { return this->owner != nullptr; }
+
+    inline std::span<T> writable() {
+        this->detach();
+        return this->owned;
+    }
+    inline void resize(std::size_t count) { this->edit([&] { this->owned.resize(count); }); }
+    inline void assign(std::size_t count, const T& value) {
+        this->owner.reset();
+        this->edit([&] { this->owned.assign(count, value); });
+    }
+    inline void push_back(const T& value) { this->edit([&] { this->owned.push_back(value); }); }
+    inline void clear() {
+        this->owner.reset();
+        this->edit([&] { this->owned.clear(); });
+    }
+
+    friend bool operator==(const CsrArray& lhs, const CsrArray& rhs) {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+   private:
+    std::vector<T> owned;
+    std::span<const T> view;
+    std::shared_ptr<const void> owner;
+
+    inline void detach() {
+        if (!this->owner) return;
+        this->owned.assign(this->view.begin(), this->view.end());
+        this->view = this->owned;
+        this->owner.reset();
+    }
+    template <typename Change>
+    inline void edit(Change change) {
+        this->detach();
+        change();
+        this->view = this->owned;
+    }
+};
+
+// Compressed sparse row adjacency. Vertex indices are positions in the vertices vector, the
+// out-neighbours of v are targets[offsets[v]] .. targets[offsets[v + 1] - 1]. weights is
+// either empty (unweighted) or parallel to targets. version is the GraphStore version the
+// snapshot was built from, 0 for graphs built outside a store.
+struct Graph {
+    CsrArray<int> offsets{0};
+    CsrArray<int> targets;
+    CsrArray<double> weights;
+    unsigned long version = 0;
+
+    inline int vertexCount() const { return static_cast<int>(this->offsets.size()) - 1; }
+    inline int edgeCount() const { return static_cast<int>(this->targets.size()); }
+    inline bool isWeighted() const { return !this->weights.empty(); }
+    inline bool contains(int vertex) const { return vertex >= 0 && vertex < this->vertexCount(); }
+};
+
+#endif  // GRAPH_HPP
@@ -0,0 +1,325 @@
+#include "graphfile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace graphfile;
+
+namespace {
+
+constexpr std::uint64_t sectionAlignment = 64;
+// elements buffered per fwrite while saving
+constexpr std::size_t chunkSize = 1 << 16;
+
+inline std::uint64_t alignUp(std::uint64_t offset) {
+    return (offset + sectionAlignment - 1) / sectionAlignment * sectionAlignment;
+}
+
+std::array<std::uint64_t, SectionCount> sectionSizes(const Header& header) {
+    const std::uint64_t v = header.vertexCount;
+    const std::uint64_t e = header.edgeCount;
+
+    std::array<std::uint64_t, SectionCount> sizes{};
+    sizes[Positions] = v * sizeof(Vector2);
+    sizes[Radii] = v * sizeof(float);
+    sizes[Colors] = v * sizeof(Color);
+    sizes[Generations] = v * sizeof(std::uint64_t);
+    sizes[VertexFlags] = v;
+    sizes[LabelOffsets] = (v + 1) * sizeof(std::uint64_t);
+    sizes[Labels] = header.labelBytes;
+    sizes[EdgeOffsets] = (v + 1) * sizeof(std::int32_t);
+    sizes[Targets] = e * sizeof(std::int32_t);
+    sizes[EdgeIds] = e * sizeof(std::int32_t);
+    sizes[WeightKinds] = e;
+    sizes[Weights] = e * sizeof(std::uint64_t);
+    sizes[WeightValues] = e * sizeof(double);
+    sizes[EdgeFlags] = e;
+    return sizes;
+}
+
+// fills in the section offsets, returns the file size
+std::uint64_t layout(Header& header) {
+    auto sizes = sectionSizes(header);
+    std::uint64_t offset = alignUp(sizeof(Header));
+    for (int section = 0; section < SectionCount; ++section) {
+        header.sections[section] = offset;
+        offset = alignUp(offset + sizes[section]);
+    }
+    return offset;
+}
+
+bool validHeader(const std::byte* data, std::size_t size) {
+    if (size < sizeof(Header)) return false;
+
+    const Header& header = *reinterpret_cast<const Header*>(data);
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != formatVersion ||
+        header.byteOrder != byteOrderMark)
+        return false;
+
+    // ids are ints in memory, this also keeps the size arithmetic below from overflowing
+    constexpr std::uint64_t maxCount = 0x7fffffff;
+    if (header.vertexCount >= maxCount || header.edgeCount >= maxCount || header.labelBytes > size)
+        return false;
+
+    auto sizes = sectionSizes(header);
+    for (int section = 0; section < SectionCount; ++section) {
+        std::uint64_t offset = header.sections[section];
+        if (offset % sectionAlignment != 0 || offset > size || sizes[section] > size - offset)
+            return false;
+    }
+    return true;
+}
+
+class Writer {
+   public:
+    explicit Writer(std::FILE* file) : file(file) {}
+
+    bool ok = true;
+
+    void bytes(const void* data, std::size_t count) {
+        if (this->ok && std::fwrite(data, 1, count, this->file) != count) this->ok = false;
+        this->written += count;
+    }
+
+    // each(emit) calls emit once per element in file order
+    template <typename T, typename Each>
+    void section(std::uint64_t offset, Each each) {
+        static constexpr char zeros[sectionAlignment]{};
+        while (this->written < offset)
+            this->bytes(zeros, std::min<std::uint64_t>(sizeof(zeros), offset - this->written));
+
+        std::vector<T> chunk;
+        chunk.reserve(chunkSize);
+        each([&](const T& value) {
+            chunk.push_back(value);
+            if (chunk.size() == chunkSize) {
+                this->bytes(chunk.data(), chunk.size() * sizeof(T));
+                chunk.clear();
+            }
+        });
+        this->bytes(chunk.data(), chunk.size() * sizeof(T));
+    }
+
+   private:
+    std::FILE* file;
+    std::uint64_t written = 0;
+};
+
+}  // namespace
+
+bool saveGraph(const GraphStore& store, const std::string& path) {
+    const std::vector<Vertex>& vertices = store.vertices();
+
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = formatVersion;
+    header.byteOrder = byteOrderMark;
+    header.vertexCount = vertices.size();
+    header.edgeCount = store.edges().size();
+    for (const Vertex& vertex : vertices) header.labelBytes += vertex.label.size();
+    const std::uint64_t fileSize = layout(header);
+
+    // edges go out grouped by source, in each vertex's insertion order
+    auto eachEdge = [&](auto visit) {
+        for (const Vertex& vertex : vertices)
+            for (int position : store.outEdges(vertex.id)) visit(store.edges()[position]);
+    };
+
+    // written next to the target and renamed over it, a failed save leaves the old file alone
+    const std::string partialPath = path + ".partial";
+    std::FILE* file = std::fopen(partialPath.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    Writer out(file);
+    out.bytes(&header, sizeof(header));
+
+    out.section<Vector2>(header.sections[Positions], [&](auto emit) {
+        for (const Vertex& vertex : vertices) emit(vertex.pos);
+    });
+    out.section<float>(header.sections[Radii], [&](auto emit) {
+        for (const Vertex& vertex : vertices) emit(vertex.radius);
+    });
+    out.section<Color>(header.sections[Colors], [&](auto emit) {
+        for (const Vertex& vertex : vertices) emit(vertex.color);
+    });
+    out.section<std::uint64_t>(header.sections[Generations], [&](auto emit) {
+        for (const Vertex& vertex : vertices) emit(vertex.generation);
+    });
+    out.section<std::uint8_t>(header.sections[VertexFlags], [&](auto emit) {
+        for (const Vertex& vertex : vertices) emit(vertex.usable ? 1 : 0);
+    });
+    out.section<std::uint64_t>(header.sections[LabelOffsets], [&](auto emit) {
+        std::uint64_t offset = 0;
+        emit(offset);
+        for (const Vertex& vertex : vertices) emit(offset += vertex.label.size());
+    });
+    out.section<char>(header.sections[Labels], [&](auto emit) {
+        for (const Vertex& vertex : vertices)
+            for (char c : vertex.label) emit(c);
+    });
+    out.section<std::int32_t>(header.sections[EdgeOffsets], [&](auto emit) {
+        std::int32_t offset = 0;
+        emit(offset);
+        for (const Vertex& vertex : vertices)
+            emit(offset += static_cast<std::int32_t>(store.outEdges(vertex.id).size()));
+    });
+    out.section<std::int32_t>(header.sections[Targets], [&](auto emit) {
+        eachEdge([&](const Edge& edge) { emit(edge.toId); });
+    });
+    out.section<std::int32_t>(header.sections[EdgeIds], [&](auto emit) {
+        eachEdge([&](const Edge& edge) { emit(edge.id); });
+    });
+    out.section<std::uint8_t>(header.sections[WeightKinds], [&](auto emit) {
+        eachEdge([&](const Edge& edge) {
+            if (!edge.weighted)
+                emit(Unweighted);
+            else
+                emit(std::holds_alternative<std::int64_t>(edge.weight.value) ? Integer : Fraction);
+        });
+    });
+    out.section<std::uint64_t>(header.sections[Weights], [&](auto emit) {
+        eachEdge([&](const Edge& edge) {
+            std::uint64_t bits = 0;
+            if (edge.weighted)
+                std::visit([&bits](auto number) { std::memcpy(&bits, &number, sizeof(bits)); },
+                           edge.weight.value);
+            emit(bits);
+        });
+    });
+    out.section<double>(header.sections[WeightValues], [&](auto emit) {
+        eachEdge([&](const Edge& edge) { emit(edge.weighted ? edge.weight.asDouble() : 0.0); });
+    });
+    out.section<std::uint8_t>(header.sections[EdgeFlags], [&](auto emit) {
+        eachEdge([&](const Edge& edge) { emit(edge.usable ? 1 : 0); });
+    });
+    out.section<char>(fileSize, [](auto) {});
+
+    bool written = out.ok;
+    written = std::fclose(file) == 0 && written;
+
+    std::error_code error;
+    if (written) std::filesystem::rename(partialPath, path, error);
+    if (!written || error) {
+        std::filesystem::remove(partialPath, error);
+        return false;
+    }
+    return true;
+}
+
+std::optional<MappedGraphFile> MappedGraphFile::open(const std::string& path) {
+    auto file = MappedFile::open(path);
+    if (!file.has_value() || !validHeader(file->data(), file->size())) return std::nullopt;
+    return MappedGraphFile(std::move(*file));
+}
+
+std::string_view MappedGraphFile::label(int vertex) const {
+    auto offsets = this->section<std::uint64_t>(LabelOffsets, this->vertexCount() + 1);
+    std::uint64_t begin = offsets[vertex];
+    std::uint64_t end = offsets[vertex + 1];
+    // contents aren't checked on open, a corrupt table gives empty labels instead of overreads
+    if (begin > end || end > this->header().labelBytes) return {};
+
+    const std::byte* labels = this->file->data() + this->header().sections[Labels];
+    return {reinterpret_cast<const char*>(labels + begin), static_cast<std::size_t>(end - begin)};
+}
+
+std::optional<Weight> MappedGraphFile::weight(int edge) const {
+    const std::byte* bits =
+        this->file->data() + this->header().sections[Weights] + edge * sizeof(std::uint64_t);
+
+    switch (this->weightKinds()[edge]) {
+        case Integer: {
+            std::int64_t number;
+            std::memcpy(&number, bits, sizeof(number));
+            return Weight(number);
+        }
+        case Fraction: {
+            double number;
+            std::memcpy(&number, bits, sizeof(number));
+            return Weight(number);
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+std::optional<Graph> MappedGraphFile::graph(bool weighted) const {
+    auto offsets = this->offsets();
+    auto targets = this->targets();
+
+    // the adjacency is only checked here, opening stays O(1)
+    if (offsets.front() != 0 || offsets.back() != this->edgeCount() ||
+        !std::is_sorted(offsets.begin(), offsets.end()) ||
+        std::any_of(targets.begin(), targets.end(), [this](std::int32_t target) {
+            return target < 0 || target >= this->vertexCount();
+        }))
+        return std::nullopt;
+
+    Graph graph;
+    graph.offsets = CsrArray<int>(offsets, this->file);
+    graph.targets = CsrArray<int>(targets, this->file);
+    if (weighted) graph.weights = CsrArray<double>(this->weightValues(), this->file);
+    return graph;
+}
+
+bool loadGraph(const std::string& path, GraphStore& store) {
+    auto file = MappedGraphFile::open(path);
+    if (!file.has_value()) return false;
+
+    auto offsets = file->offsets();
+    if (offsets.front() != 0 || offsets.back() != file->edgeCount() ||
+        !std::is_sorted(offsets.begin(), offsets.end()))
+        return false;
+
+    auto positions = file->positions();
+    auto radii = file->radii();
+    auto colors = file->colors();
+    auto generations = file->generations();
+
+    std::vector<Vertex> vertices;
+    vertices.reserve(file->vertexCount());
+    for (int v = 0; v < file->vertexCount(); ++v) {
+        Vertex& vertex = vertices.emplace_back(positions[v], radii[v], colors[v],
+                                               std::string(file->label(v)));
+        vertex.generation = generations[v];
+        vertex.usable = file->vertexUsable(v);
+    }
+
+    auto targets = file->targets();
+    auto edgeIds = file->edgeIds();
+
+    std::vector<Edge> edges;
+    edges.reserve(file->edgeCount());
+    for (int v = 0; v < file->vertexCount(); ++v) {
+        for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+            auto weight = file->weight(i);
+            Edge& edge = weight.has_value() ? edges.emplace_back(v, targets[i], *weight)
+                                            : edges.emplace_back(v, targets[i]);
+            edge.id = edgeIds[i];
+            edge.usable = file->edgeUsable(i);
+        }
+    }
+
+    // out of range targets are dropped here
+    store.load(std::move(vertices), std::move(edges));
+
+    // when nothing was dropped the file's CSR is exactly the store's
+    if (static_cast<int>(store.edges().size()) == file->edgeCount()) {
+        if (auto weighted = file->graph(true)) {
+            Graph unweighted = *weighted;
+            unweighted.weights.clear();
+            store.adoptSnapshots(std::move(unweighted), std::move(*weighted));
+        }
+    }
+    return true;
+}
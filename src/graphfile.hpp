@@ -0,0 +1,143 @@
+#ifndef GRAPHFILE_HPP
+#define GRAPHFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "graph.hpp"
+#include "graphstore.hpp"
+#include "mappedfile.hpp"
+#include "types.hpp"
+#include "weight.hpp"
+
+// .gphz files: a fixed header followed by flat arrays that are used in place once the file is
+// mapped. Vertex arrays have one entry per vertex slot (dead slots included, so ids survive a
+// round trip), edge arrays are in CSR order: the out-edges of v are edges offsets[v] ..
+// offsets[v + 1] - 1. Every section starts on a 64 byte boundary. Multi-byte values are in the
+// writer's byte order, which the header records so a foreign file is rejected instead of misread.
+namespace graphfile {
+
+constexpr char magic[4] = {'G', 'P', 'H', 'Z'};
+constexpr std::uint32_t formatVersion = 2;
+constexpr std::uint32_t byteOrderMark = 0x01020304;
+
+enum Section {
+    Positions,     // Vector2 per vertex
+    Radii,         // float per vertex
+    Colors,        // Color per vertex
+    Generations,   // uint64 per vertex
+    VertexFlags,   // uint8 per vertex, bit 0 usable
+    LabelOffsets,  // uint64 per vertex + 1, byte ranges in Labels
+    Labels,        // label bytes back to back, no terminators
+    EdgeOffsets,   // int32 per vertex + 1
+    Targets,       // int32 per edge
+    EdgeIds,       // int32 per edge
+    WeightKinds,   // uint8 per edge, see WeightKind
+    Weights,       // 8 bytes per edge, int64 or double as WeightKinds says, 0 when unweighted
+    WeightValues,  // double per edge, the weight as the algorithms see it, 0 when unweighted
+    EdgeFlags,     // uint8 per edge, bit 0 usable
+    SectionCount
+};
+
+enum WeightKind : std::uint8_t { Unweighted, Integer, Fraction };
+
+struct Header {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t reserved;
+    std::uint64_t vertexCount;
+    std::uint64_t edgeCount;
+    std::uint64_t labelBytes;
+    // byte offset of each section from the start of the file
+    std::uint64_t sections[SectionCount];
+};
+
+}  // namespace graphfile
+
+// Writes the store section by section through a small buffer, so saving needs no copy of the
+// graph. false when the file can't be written.
+bool saveGraph(const GraphStore&, const std::string& path);
+
+// Read-only view of a .gphz file. Opening maps the file and checks the header and section
+// bounds, nothing is parsed or copied, so it takes the same time for any graph size. The arrays
+// stay valid for the lifetime of the object and of every graph() taken from it.
+class MappedGraphFile {
+   public:
+    // nullopt when the file is missing, truncated or not a supported .gphz file
+    static std::optional<MappedGraphFile> open(const std::string& path);
+
+    inline int vertexCount() const { return static_cast<int>(this->header().vertexCount); }
+    inline int edgeCount() const { return static_cast<int>(this->header().edgeCount); }
+
+    inline std::span<const Vector2> positions() const {
+        return this->section<Vector2>(graphfile::Positions, this->vertexCount());
+    }
+    inline std::span<const float> radii() const {
+        return this->section<float>(graphfile::Radii, this->vertexCount());
+    }
+    inline std::span<const Color> colors() const {
+        return this->section<Color>(graphfile::Colors, this->vertexCount());
+    }
+    inline std::span<const std::uint64_t> generations() const {
+        return this->section<std::uint64_t>(graphfile::Generations, this->vertexCount());
+    }
+    inline bool vertexUsable(int vertex) const {
+        return this->section<std::uint8_t>(graphfile::VertexFlags, this->vertexCount())[vertex] & 1;
+    }
+    std::string_view label(int vertex) const;
+
+    inline std::span<const std::int32_t> offsets() const {
+        return this->section<std::int32_t>(graphfile::EdgeOffsets, this->vertexCount() + 1);
+    }
+    inline std::span<const std::int32_t> targets() const {
+        return this->section<std::int32_t>(graphfile::Targets, this->edgeCount());
+    }
+    inline std::span<const std::int32_t> edgeIds() const {
+        return this->section<std::int32_t>(graphfile::EdgeIds, this->edgeCount());
+    }
+    inline std::span<const std::uint8_t> weightKinds() const {
+        return this->section<std::uint8_t>(graphfile::WeightKinds, this->edgeCount());
+    }
+    // nullopt for unweighted edges
+    std::optional<Weight> weight(int edge) const;
+    inline std::span<const double> weightValues() const {
+        return this->section<double>(graphfile::WeightValues, this->edgeCount());
+    }
+    inline bool edgeUsable(int edge) const {
+        return this->section<std::uint8_t>(graphfile::EdgeFlags, this->edgeCount())[edge] & 1;
+    }
+
+    // CSR for the algorithms over the mapped arrays, nothing is copied and the graph keeps the
+    // mapping alive. Weighted graphs treat unweighted edges as weight 0. nullopt when the
+    // adjacency arrays are inconsistent, which is checked in O(V + E)
+    std::optional<Graph> graph(bool weighted) const;
+
+   private:
+    std::shared_ptr<const MappedFile> file;
+
+    explicit MappedGraphFile(MappedFile file)
+        : file(std::make_shared<const MappedFile>(std::move(file))) {}
+
+    inline const graphfile::Header& header() const {
+        return *reinterpret_cast<const graphfile::Header*>(this->file->data());
+    }
+    template <typename T>
+    inline std::span<const T> section(graphfile::Section section, std::size_t count) const {
+        return {reinterpret_cast<const T*>(this->file->data() + this->header().sections[section]),
+                count};
+    }
+};
+
+// Replaces the contents of the store with the file, false (store untouched) when it can't be
+// opened. Edges with dangling endpoints are dropped like GraphStore::load does. When none are,
+// the store's CSR snapshots borrow the mapped arrays until the graph is edited.
+bool loadGraph(const std::string& path, GraphStore&);
+
+#endif  // GRAPHFILE_HPP
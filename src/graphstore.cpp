@@ -0,0 +1,420 @@
+#include "graphstore.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+Vertex& GraphStore::addVertex(const Vector2& pos, float radius, const Color& color) {
+    int slot;
+    if (!this->freeSlots.empty()) {
+        slot = this->freeSlots.back();
+        this->freeSlots.pop_back();
+        this->vertexList[slot] = Vertex(pos, radius, color);
+    } else {
+        slot = static_cast<int>(this->vertexList.size());
+        this->vertexList.emplace_back(pos, radius, color);
+        this->outIncidence.emplace_back();
+        this->inIncidence.emplace_back();
+    }
+
+    Vertex& vertex = this->vertexList[slot];
+    vertex.id = slot;
+    vertex.generation = this->nextGeneration++;
+    vertex.label = defaultLabel(vertex.id);
+
+    if (this->gridBuilt) this->grid.insertVertex(vertex.id, pos, radius);
+    ++this->topologyEdits;
+
+    return vertex;
+}
+
+void GraphStore::removeVertex(int vertexId) {
+    if (!this->isUsable(vertexId)) return;
+
+    this->vertexList[vertexId].usable = false;
+    if (this->gridBuilt) this->grid.removeVertex(vertexId);
+
+    // removeEdge moves edges around in the edge list, so collect the ids first
+    std::vector<int> incident;
+    for (int position : this->outIncidence[vertexId])
+        incident.push_back(this->edgeList[position].id);
+    for (int position : this->inIncidence[vertexId])
+        incident.push_back(this->edgeList[position].id);
+    for (int edgeId : incident) this->removeEdge(edgeId);
+
+    this->freeSlots.push_back(vertexId);
+    ++this->topologyEdits;
+}
+
+void GraphStore::moveVertex(int vertexId, const Vector2& pos) {
+    if (!this->isUsable(vertexId)) return;
+
+    Vertex& vertex = this->vertexList[vertexId];
+    vertex.pos = pos;
+    if (this->gridBuilt) {
+        this->grid.insertVertex(vertexId, pos, vertex.radius);
+        for (int position : this->outIncidence[vertexId])
+            this->indexEdge(this->edgeList[position]);
+        for (int position : this->inIncidence[vertexId])
+            this->indexEdge(this->edgeList[position]);
+    }
+    ++this->moveCount;
+}
+
+void GraphStore::setLayout(const std::vector<Vector2>& positions, SpatialIndex& index) {
+    for (size_t slot = 0; slot < this->vertexList.size(); ++slot)
+        this->vertexList[slot].pos = positions[slot];
+    std::swap(this->grid, index);
+    this->gridBuilt = true;
+    ++this->moveCount;
+}
+
+VertexHandle GraphStore::handle(int vertexId) const {
+    if (!this->isUsable(vertexId)) return {};
+    return {vertexId, this->vertexList[vertexId].generation};
+}
+
+Vertex* GraphStore::resolve(const VertexHandle& handle) {
+    if (!this->isUsable(handle.id)) return nullptr;
+
+    Vertex& vertex = this->vertexList[handle.id];
+    return vertex.generation == handle.generation ? &vertex : nullptr;
+}
+
+std::vector<int> GraphStore::compact() {
+    std::vector<int> remap(this->vertexList.size(), -1);
+    std::vector<Vertex> packed;
+    std::vector<std::vector<int>> packedOut;
+    std::vector<std::vector<int>> packedIn;
+    packed.reserve(this->vertexCount());
+    packedOut.reserve(this->vertexCount());
+    packedIn.reserve(this->vertexCount());
+
+    for (size_t slot = 0; slot < this->vertexList.size(); ++slot) {
+        if (!this->vertexList[slot].usable) continue;
+
+        remap[slot] = static_cast<int>(packed.size());
+        packed.push_back(std::move(this->vertexList[slot]));
+        // a default label names the old id, it follows the vertex to its new one
+        if (packed.back().label == defaultLabel(static_cast<int>(slot)))
+            packed.back().label = defaultLabel(remap[slot]);
+        packed.back().id = remap[slot];
+        // moved vertices get a fresh generation so handles taken before compacting go stale
+        packed.back().generation = this->nextGeneration++;
+        packedOut.push_back(std::move(this->outIncidence[slot]));
+        packedIn.push_back(std::move(this->inIncidence[slot]));
+    }
+
+    this->vertexList = std::move(packed);
+    this->outIncidence = std::move(packedOut);
+    this->inIncidence = std::move(packedIn);
+    this->freeSlots.clear();
+    for (Edge& edge : this->edgeList) {
+        edge.fromId = remap[edge.fromId];
+        edge.toId = remap[edge.toId];
+    }
+
+    // both are keyed by vertex ids, built again on their next use
+    this->edgeByEndpoints.clear();
+    this->edgeLookupsBuilt = false;
+    this->grid.clear();
+    this->gridBuilt = false;
+
+    ++this->topologyEdits;
+    return remap;
+}
+
+void GraphStore::load(std::vector<Vertex> vertices, std::vector<Edge> edges) {
+    this->vertexList = std::move(vertices);
+    this->freeSlots.clear();
+    this->edgePosition.clear();
+    this->edgeByEndpoints.clear();
+    this->edgeLookupsBuilt = false;
+    this->grid.clear();
+    this->gridBuilt = false;
+
+    // the endpoints are checked on a flag per slot, going through the vertex list would touch a
+    // whole Vertex per endpoint
+    const int slots = static_cast<int>(this->vertexList.size());
+    std::vector<bool> usable(slots);
+    for (int slot = 0; slot < slots; ++slot) {
+        Vertex& vertex = this->vertexList[slot];
+        vertex.id = slot;
+        this->nextGeneration = std::max(this->nextGeneration, vertex.generation + 1);
+        usable[slot] = vertex.usable;
+        if (!vertex.usable) this->freeSlots.push_back(vertex.id);
+    }
+    auto usableEndpoint = [&](int id) { return id >= 0 && id < slots && usable[id]; };
+
+    // the edges are filtered in place, so a bulk load never holds two copies of the edge list
+    this->edgeList = std::move(edges);
+    int minId = std::numeric_limits<int>::max(), maxId = std::numeric_limits<int>::min();
+    for (const Edge& edge : this->edgeList) {
+        minId = std::min(minId, edge.id);
+        maxId = std::max(maxId, edge.id);
+    }
+    if (!this->edgeList.empty())
+        Edge::instanceCounter = std::max(Edge::instanceCounter, maxId + 1);
+
+    // repeated ids are found on a bitmap over the id range, ids handed out by the store and the
+    // importer are dense. Only scattered ids need a hash set
+    const long long idRange = static_cast<long long>(maxId) - minId + 1;
+    const bool dense = idRange <= 8 * static_cast<long long>(this->edgeList.size()) + 1024;
+    std::vector<bool> seenIds(dense ? static_cast<size_t>(std::max(idRange, 0LL)) : 0);
+    std::unordered_set<int> seenIdSet;
+    auto firstWithId = [&](int id) {
+        if (!dense) return seenIdSet.insert(id).second;
+        if (seenIds[id - minId]) return false;
+        seenIds[id - minId] = true;
+        return true;
+    };
+
+    size_t kept = 0;
+    for (size_t i = 0; i < this->edgeList.size(); ++i) {
+        Edge& edge = this->edgeList[i];
+        if (!usableEndpoint(edge.fromId) || !usableEndpoint(edge.toId)) continue;
+        if (!firstWithId(edge.id)) continue;
+        if (kept != i) this->edgeList[kept] = std::move(edge);
+        ++kept;
+    }
+    this->edgeList.erase(this->edgeList.begin() + kept, this->edgeList.end());
+
+    // repeated (from, to) pairs show up while walking each source's edges in list order: a
+    // target already reached from this source is a repeat, only the first edge is kept
+    this->buildIncidence();
+    std::vector<int> lastSource(this->vertexList.size(), -1);
+    std::vector<bool> repeated;
+    for (size_t v = 0; v < this->vertexList.size(); ++v) {
+        for (int position : this->outIncidence[v]) {
+            int& last = lastSource[this->edgeList[position].toId];
+            if (last != static_cast<int>(v)) {
+                last = static_cast<int>(v);
+                continue;
+            }
+            if (repeated.empty()) repeated.resize(this->edgeList.size());
+            repeated[position] = true;
+        }
+    }
+    if (!repeated.empty()) {
+        kept = 0;
+        for (size_t i = 0; i < this->edgeList.size(); ++i) {
+            if (repeated[i]) continue;
+            if (kept != i) this->edgeList[kept] = std::move(this->edgeList[i]);
+            ++kept;
+        }
+        this->edgeList.erase(this->edgeList.begin() + kept, this->edgeList.end());
+        this->buildIncidence();
+    }
+
+    ++this->topologyEdits;
+}
+
+void GraphStore::buildIncidence() {
+    // sized from a degree count, grown edge by edge they would end up with up to half of their
+    // capacity unused
+    const size_t slots = this->vertexList.size();
+    std::vector<int> outDegree(slots), inDegree(slots);
+    for (const Edge& edge : this->edgeList) {
+        ++outDegree[edge.fromId];
+        ++inDegree[edge.toId];
+    }
+    this->outIncidence.assign(slots, {});
+    this->inIncidence.assign(slots, {});
+    for (size_t slot = 0; slot < slots; ++slot) {
+        this->outIncidence[slot].reserve(outDegree[slot]);
+        this->inIncidence[slot].reserve(inDegree[slot]);
+    }
+    for (size_t i = 0; i < this->edgeList.size(); ++i) {
+        this->outIncidence[this->edgeList[i].fromId].push_back(static_cast<int>(i));
+        this->inIncidence[this->edgeList[i].toId].push_back(static_cast<int>(i));
+    }
+}
+
+void GraphStore::buildEdgeLookups() const {
+    if (this->edgeLookupsBuilt) return;
+    this->edgePosition.clear();
+    this->edgeByEndpoints.clear();
+    this->edgePosition.reserve(this->edgeList.size());
+    this->edgeByEndpoints.reserve(this->edgeList.size());
+    for (size_t i = 0; i < this->edgeList.size(); ++i) {
+        const Edge& edge = this->edgeList[i];
+        this->edgePosition.emplace(edge.id, static_cast<int>(i));
+        this->edgeByEndpoints.emplace(endpointKey(edge.fromId, edge.toId), edge.id);
+    }
+    this->edgeLookupsBuilt = true;
+}
+
+void GraphStore::buildGrid() const {
+    if (this->gridBuilt) return;
+    for (const Vertex& vertex : this->vertexList) {
+        if (vertex.usable) this->grid.insertVertex(vertex.id, vertex.pos, vertex.radius);
+    }
+    for (const Edge& edge : this->edgeList) this->indexEdge(edge);
+    this->gridBuilt = true;
+}
+
+Edge* GraphStore::addEdge(const Edge& edge) {
+    if (!this->isUsable(edge.fromId) || !this->isUsable(edge.toId)) return nullptr;
+    this->buildEdgeLookups();
+    if (!this->edgeByEndpoints.try_emplace(endpointKey(edge.fromId, edge.toId), edge.id).second)
+        return nullptr;
+
+    const int position = static_cast<int>(this->edgeList.size());
+    this->edgePosition[edge.id] = position;
+    this->edgeList.push_back(edge);
+    this->outIncidence[edge.fromId].push_back(position);
+    this->inIncidence[edge.toId].push_back(position);
+    if (this->gridBuilt) this->indexEdge(edge);
+    ++this->topologyEdits;
+
+    return &this->edgeList.back();
+}
+
+void GraphStore::removeEdge(int edgeId) {
+    this->buildEdgeLookups();
+    auto position = this->edgePosition.find(edgeId);
+    if (position == this->edgePosition.end()) return;
+
+    const int index = position->second;
+    const Edge& edge = this->edgeList[index];
+
+    // erase keeps the remaining incident edges in insertion order, O(degree)
+    auto& out = this->outIncidence[edge.fromId];
+    out.erase(std::find(out.begin(), out.end(), index));
+    auto& in = this->inIncidence[edge.toId];
+    in.erase(std::find(in.begin(), in.end(), index));
+    this->edgeByEndpoints.erase(endpointKey(edge.fromId, edge.toId));
+
+    // swap with the last edge so removal doesn't shift the whole list, the moved edge keeps its
+    // place in its endpoints' incidence lists
+    const int last = static_cast<int>(this->edgeList.size()) - 1;
+    if (index != last) {
+        Edge& moved = this->edgeList[index];
+        moved = std::move(this->edgeList.back());
+        this->edgePosition[moved.id] = index;
+        auto& movedOut = this->outIncidence[moved.fromId];
+        *std::find(movedOut.begin(), movedOut.end(), last) = index;
+        auto& movedIn = this->inIncidence[moved.toId];
+        *std::find(movedIn.begin(), movedIn.end(), last) = index;
+    }
+    this->edgeList.pop_back();
+    this->edgePosition.erase(edgeId);
+    if (this->gridBuilt) this->grid.removeEdge(edgeId);
+
+    ++this->topologyEdits;
+}
+
+void GraphStore::setWeight(int edgeId, const Weight& weight) {
+    this->buildEdgeLookups();
+    auto position = this->edgePosition.find(edgeId);
+    if (position == this->edgePosition.end()) return;
+
+    Edge& edge = this->edgeList[position->second];
+    if (edge.weight == weight) return;
+
+    edge.weight = weight;
+    // a snapshot that is stale anyway gets rebuilt whole, no need to remember the edge
+    if (this->weightedTopology == this->topologyEdits) this->reweighted.push_back(position->second);
+    ++this->weightEdits;
+}
+
+Edge* GraphStore::findEdge(int edgeId) {
+    this->buildEdgeLookups();
+    auto position = this->edgePosition.find(edgeId);
+    return position == this->edgePosition.end() ? nullptr : &this->edgeList[position->second];
+}
+
+const Edge* GraphStore::findEdge(int edgeId) const {
+    this->buildEdgeLookups();
+    auto position = this->edgePosition.find(edgeId);
+    return position == this->edgePosition.end() ? nullptr : &this->edgeList[position->second];
+}
+
+Edge* GraphStore::findEdge(int fromId, int toId) {
+    this->buildEdgeLookups();
+    auto edge = this->edgeByEndpoints.find(endpointKey(fromId, toId));
+    return edge == this->edgeByEndpoints.end() ? nullptr : this->findEdge(edge->second);
+}
+
+void GraphStore::indexEdge(const Edge& edge) const {
+    this->grid.insertEdge(edge.id, this->vertexList[edge.fromId].pos,
+                           this->vertexList[edge.toId].pos);
+}
+
+bool GraphStore::adoptSnapshots(Graph unweighted, Graph weighted) {
+    const auto edgeCount = this->edgeList.size();
+    if (unweighted.offsets.size() != this->vertexList.size() + 1 ||
+        unweighted.targets.size() != edgeCount || unweighted.isWeighted() ||
+        weighted.offsets.size() != this->vertexList.size() + 1 ||
+        weighted.targets.size() != edgeCount || weighted.weights.size() != edgeCount)
+        return false;
+
+    this->unweightedSnapshot = std::move(unweighted);
+    this->weightedSnapshot = std::move(weighted);
+    this->unweightedTopology = this->topologyEdits;
+    this->weightedTopology = this->topologyEdits;
+    this->reweighted.clear();
+    return true;
+}
+
+const Graph& GraphStore::graph() {
+    // weights aren't part of it, a weight edit only restamps it
+    if (this->unweightedTopology != this->topologyEdits) {
+        this->rebuild(this->unweightedSnapshot, false);
+        this->unweightedTopology = this->topologyEdits;
+    }
+    this->unweightedSnapshot.version = this->version();
+    return this->unweightedSnapshot;
+}
+
+const Graph& GraphStore::weightedGraph() {
+    if (this->weightedTopology != this->topologyEdits) {
+        this->rebuild(this->weightedSnapshot, true);
+        this->weightedTopology = this->topologyEdits;
+    } else if (!this->reweighted.empty()) {
+        // the slot of an edge is its place in its source's incidence list, O(degree) per edit
+        auto weights = this->weightedSnapshot.weights.writable();
+        for (int position : this->reweighted) {
+            const Edge& edge = this->edgeList[position];
+            const auto& out = this->outIncidence[edge.fromId];
+            const int slot = this->weightedSnapshot.offsets[edge.fromId] +
+                             static_cast<int>(std::find(out.begin(), out.end(), position) -
+                                              out.begin());
+            weights[slot] = edge.weight.asDouble();
+        }
+    }
+    this->reweighted.clear();
+    this->weightedSnapshot.version = this->version();
+    return this->weightedSnapshot;
+}
+
+void GraphStore::rebuild(Graph& snapshot, bool weighted) const {
+    const int vertexCount = static_cast<int>(this->vertexList.size());
+    // an adopted snapshot is replaced, there is no point copying it first
+    if (snapshot.targets.borrowed()) snapshot = Graph();
+
+    snapshot.offsets.resize(vertexCount + 1);
+    auto offsets = snapshot.offsets.writable();
+    offsets[0] = 0;
+    for (int v = 0; v < vertexCount; ++v)
+        offsets[v + 1] = offsets[v] + static_cast<int>(this->outIncidence[v].size());
+
+    snapshot.targets.resize(offsets.back());
+    snapshot.weights.resize(weighted ? offsets.back() : 0);
+    auto targets = snapshot.targets.writable();
+    auto weights = snapshot.weights.writable();
+
+    // the incidence lists hold edge list positions, no lookup per edge
+    int slot = 0;
+    for (int v = 0; v < vertexCount; ++v) {
+        for (int position : this->outIncidence[v]) {
+            const Edge& edge = this->edgeList[position];
+            targets[slot] = edge.toId;
+            if (weighted) weights[slot] = edge.weight.asDouble();
+            ++slot;
+        }
+    }
+}
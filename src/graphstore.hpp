@@ -0,0 +1,160 @@
+#ifndef GRAPHSTORE_HPP
+#define GRAPHSTORE_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "edge.hpp"
+#include "graph.hpp"
+#include "spatialindex.hpp"
+#include "vertex.hpp"
+#include "weight.hpp"
+
+// Refers to one incarnation of a vertex slot. Stops resolving once that vertex is deleted, even
+// if the slot has been reused since, and after the store is compacted.
+struct VertexHandle {
+    int id = -1;
+    unsigned long generation = 0;
+};
+
+// Owns the vertices and edges and keeps the adjacency up to date as they are edited, so a search
+// only pays for the traversal. Every topology or weight edit bumps version(); the CSR snapshots
+// handed to the algorithms carry the version they were taken at. They are only rebuilt after a
+// topology edit, weight edits are patched into the cached weighted snapshot in place.
+// Vertex ids are their index in vertices(), the list is a slot map: deleted vertices stay as
+// unusable slots on a free list and are handed out again by addVertex, compact() packs the live
+// vertices together and remaps the edges. Positions are mirrored into a SpatialIndex, so they
+// have to be changed through moveVertex. The lookups by edge id and by endpoints and the
+// SpatialIndex are only built on their first use, so loading a graph costs no hashing or grid
+// insert per vertex or edge until something is edited or picked.
+class GraphStore {
+   public:
+    GraphStore() = default;
+
+    inline const std::vector<Vertex>& vertices() const { return this->vertexList; }
+    inline const std::vector<Edge>& edges() const { return this->edgeList; }
+    inline unsigned long version() const { return this->topologyEdits + this->weightEdits; }
+    // only bumped by edits to the vertices and edges themselves, not by setWeight, so whatever
+    // depends on the shape of the graph alone, like a layout, survives weight edits
+    inline unsigned long topologyVersion() const { return this->topologyEdits; }
+    // changes with version() and whenever vertices move, so a cached drawing of the graph is
+    // stale exactly when it differs. Labels and colors are edited in place and aren't covered
+    inline unsigned long drawVersion() const { return this->version() + this->moveCount; }
+
+    // label a vertex gets until one is typed, compact() renames vertices that still have it
+    static inline std::string defaultLabel(int vertexId) {
+        return std::string("V").append(std::to_string(vertexId));
+    }
+
+    // vertex ids index straight into the vertex list
+    inline const Vertex& vertex(int vertexId) const { return this->vertexList[vertexId]; }
+
+    Vertex& addVertex(const Vector2& pos, float radius, const Color& color);
+    void removeVertex(int vertexId);
+    void moveVertex(int vertexId, const Vector2& pos);
+    // not an edit, version() and drawVersion() stay as they are
+    inline void setColor(int vertexId, const Color& color) {
+        this->vertexList[vertexId].color = color;
+    }
+    // Moves every vertex at once, positions has one entry per vertex slot. index has to be a
+    // spatial index over exactly the usable vertices and edges at those positions, as ForceLayout
+    // publishes it; it is swapped in, so no index update happens here, and receives the old one.
+    void setLayout(const std::vector<Vector2>& positions, SpatialIndex& index);
+
+    VertexHandle handle(int vertexId) const;
+    // nullptr for stale handles
+    Vertex* resolve(const VertexHandle& handle);
+
+    inline int vertexCount() const {
+        return static_cast<int>(this->vertexList.size() - this->freeSlots.size());
+    }
+    inline int deadVertexCount() const { return static_cast<int>(this->freeSlots.size()); }
+
+    // Rebuilds the vertex list without dead slots. Vertex ids change, so every pointer, id and
+    // handle into the store is invalid afterwards; returns the old id -> new id table (-1 for
+    // dropped slots).
+    std::vector<int> compact();
+
+    // Replaces the whole graph. Vertex ids become their position in vertices, unusable vertices
+    // are kept as free slots. Edges whose endpoints are missing or unusable, and repeated
+    // (from, to) pairs or edge ids, are dropped, the first one stays. Later edges get ids above
+    // the loaded ones. O(V + E) without hashing when the edge ids are dense.
+    void load(std::vector<Vertex> vertices, std::vector<Edge> edges);
+
+    // Serves graph() and weightedGraph() from these until the next topology edit instead of
+    // building them, for a caller that already has the CSR in store order, like a mapped file.
+    // Only right after load(); false (nothing adopted) when the sizes don't match the store.
+    bool adoptSnapshots(Graph unweighted, Graph weighted);
+
+    // returns nullptr when an endpoint is missing or unusable, or the (from, to) pair already
+    // has an edge
+    Edge* addEdge(const Edge& edge);
+    void removeEdge(int edgeId);
+    void setWeight(int edgeId, const Weight& weight);
+
+    // incident edges of vertexId as positions in edges(), in insertion order. Positions change
+    // when edges are removed
+    inline const std::vector<int>& outEdges(int vertexId) const {
+        return this->outIncidence[vertexId];
+    }
+    inline const std::vector<int>& inEdges(int vertexId) const {
+        return this->inIncidence[vertexId];
+    }
+
+    Edge* findEdge(int edgeId);
+    const Edge* findEdge(int edgeId) const;
+    Edge* findEdge(int fromId, int toId);
+
+    // builds the grid first if nothing has asked for it since the last load or compact()
+    inline const SpatialIndex& spatialIndex() const {
+        this->buildGrid();
+        return this->grid;
+    }
+
+    const Graph& graph();
+    const Graph& weightedGraph();
+
+   private:
+    std::vector<Vertex> vertexList;
+    std::vector<int> freeSlots;
+    std::vector<Edge> edgeList;
+
+    std::vector<std::vector<int>> outIncidence;
+    std::vector<std::vector<int>> inIncidence;
+    // built lazily, see buildEdgeLookups() and buildGrid()
+    mutable std::unordered_map<int, int> edgePosition;
+    mutable std::unordered_map<std::uint64_t, int> edgeByEndpoints;
+    mutable bool edgeLookupsBuilt = true;
+    mutable SpatialIndex grid;
+    mutable bool gridBuilt = true;
+
+    unsigned long topologyEdits = 1;
+    unsigned long weightEdits = 0;
+    unsigned long moveCount = 0;
+    unsigned long nextGeneration = 1;
+    Graph unweightedSnapshot;
+    Graph weightedSnapshot;
+    // topologyEdits the snapshots were built at, and the edge positions reweighted since
+    unsigned long unweightedTopology = 0;
+    unsigned long weightedTopology = 0;
+    std::vector<int> reweighted;
+
+    void rebuild(Graph& snapshot, bool weighted) const;
+    void indexEdge(const Edge& edge) const;
+    // incidence lists of the edge list as it is, in list order
+    void buildIncidence();
+    void buildEdgeLookups() const;
+    void buildGrid() const;
+    static inline std::uint64_t endpointKey(int fromId, int toId) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(fromId)) << 32) |
+               static_cast<std::uint32_t>(toId);
+    }
+    inline bool isUsable(int vertexId) const {
+        return vertexId >= 0 && vertexId < static_cast<int>(this->vertexList.size()) &&
+               this->vertexList[vertexId].usable;
+    }
+};
+
+#endif  // GRAPHSTORE_HPP
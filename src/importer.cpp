@@ -0,0 +1,460 @@
+#include "importer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "edge.hpp"
+#include "mappedfile.hpp"
+#include "parallel.hpp"
+#include "vertex.hpp"
+#include "weight.hpp"
+
+namespace {
+
+// smaller inputs aren't worth starting threads for
+constexpr std::size_t bytesPerThread = 1 << 20;
+
+// what the first pass learns about a chunk
+struct EdgeCount {
+    std::size_t edges = 0;
+    int maxVertex = -1;
+};
+
+// where the second pass writes a chunk's edges and the id the next one gets
+struct EdgeCursor {
+    Edge* next = nullptr;
+    int nextId = 0;
+};
+
+struct CoordinateChunk {
+    std::vector<std::pair<int, Vector2>> coordinates;
+};
+
+struct MatrixHeader {
+    bool weighted = true;
+    bool mirrored = false;
+    bool negateMirror = false;
+};
+
+// splits one line into tokens separated by spaces, tabs or a trailing \r
+class Tokens {
+   public:
+    explicit Tokens(std::string_view line) : rest(line) {}
+
+    // empty once the line is used up
+    std::string_view next() {
+        auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+        size_t start = 0;
+        while (start < this->rest.size() && isSpace(this->rest[start])) ++start;
+        size_t end = start;
+        while (end < this->rest.size() && !isSpace(this->rest[end])) ++end;
+
+        std::string_view token = this->rest.substr(start, end - start);
+        this->rest.remove_prefix(end);
+        return token;
+    }
+
+   private:
+    std::string_view rest;
+};
+
+bool parseInteger(std::string_view token, long long& value) {
+    auto parsed = std::from_chars(token.data(), token.data() + token.size(), value);
+    return !token.empty() && parsed.ec == std::errc() && parsed.ptr == token.data() + token.size();
+}
+
+// vertex ids end up as ints, base is subtracted for 1-based formats
+bool parseVertex(std::string_view token, int base, int& vertex) {
+    long long value;
+    if (!parseInteger(token, value) || value < base ||
+        value - base >= std::numeric_limits<int>::max())
+        return false;
+    vertex = static_cast<int>(value - base);
+    return true;
+}
+
+// Weight::parse plus exponent notation, which Matrix Market files use for reals
+std::optional<Weight> parseWeight(std::string_view token) {
+    if (auto weight = Weight::parse(token)) return weight;
+
+    double value;
+    auto parsed = std::from_chars(token.data(), token.data() + token.size(), value);
+    if (token.empty() || parsed.ec != std::errc() || parsed.ptr != token.data() + token.size() ||
+        !std::isfinite(value))
+        return std::nullopt;
+    return Weight(value);
+}
+
+inline Weight negate(const Weight& weight) {
+    return std::visit([](auto number) { return Weight(-number); }, weight.value);
+}
+
+inline bool isComment(std::string_view token, char marker) {
+    return !token.empty() && token[0] == marker;
+}
+
+std::string lowercase(std::string_view text) {
+    std::string lower(text);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return lower;
+}
+
+// Calls parseLine(line, local) for every line of text[begin..], split over threads at line
+// boundaries, locals[t] collects the results of the t-th chunk. parseLine returns nullptr or
+// what is wrong with the line; on failure the first bad line in the file is reported. The split
+// only depends on the text and threadCount, and locals that are already sized are kept, so a
+// second pass can hand every chunk where its output goes.
+template <typename Local, typename ParseLine>
+bool parseLines(std::string_view text, std::size_t begin, int threadCount,
+                std::vector<Local>& locals, ParseLine parseLine, std::string* error) {
+    const std::size_t size = text.size() - begin;
+    threadCount = std::clamp(static_cast<int>(size / bytesPerThread), 1, threadCount);
+
+    std::vector<std::size_t> bounds{begin};
+    for (int t = 1; t < threadCount; ++t) {
+        std::size_t bound = std::max(bounds.back(), begin + size / threadCount * t);
+        std::size_t newline = text.find('\n', bound);
+        bounds.push_back(newline == std::string_view::npos ? text.size() : newline + 1);
+    }
+    bounds.push_back(text.size());
+
+    locals.resize(threadCount);
+    std::vector<std::size_t> errorAt(threadCount, std::string_view::npos);
+    std::vector<const char*> errorMessage(threadCount, nullptr);
+
+    runThreads(threadCount, [&](int t) {
+        std::size_t position = bounds[t];
+        while (position < bounds[t + 1]) {
+            std::size_t newline = text.find('\n', position);
+            std::size_t lineEnd = std::min(newline, bounds[t + 1]);
+
+            std::string_view line = text.substr(position, lineEnd - position);
+            if (const char* message = parseLine(line, locals[t])) {
+                errorAt[t] = position;
+                errorMessage[t] = message;
+                return;
+            }
+            position = lineEnd + 1;
+        }
+    });
+
+    for (int t = 0; t < threadCount; ++t) {
+        if (errorMessage[t] == nullptr) continue;
+
+        if (error != nullptr) {
+            long line = 1 + std::count(text.begin(), text.begin() + errorAt[t], '\n');
+            *error = "line " + std::to_string(line) + ": " + errorMessage[t];
+        }
+        return false;
+    }
+    return true;
+}
+
+// position of the first line after the header, npos when the header is incomplete
+std::size_t parseDimacsHeader(std::string_view text, int& vertexCount, std::string* error) {
+    std::size_t position = 0;
+    while (position < text.size()) {
+        std::size_t newline = std::min(text.find('\n', position), text.size());
+        Tokens tokens(text.substr(position, newline - position));
+        std::string_view kind = tokens.next();
+        position = newline + 1;
+
+        if (kind.empty() || kind == "c") continue;
+
+        long long vertices, arcs;
+        if (kind == "p" && tokens.next() == "sp" && parseInteger(tokens.next(), vertices) &&
+            parseInteger(tokens.next(), arcs) && vertices >= 0 &&
+            vertices < std::numeric_limits<int>::max()) {
+            vertexCount = static_cast<int>(vertices);
+            return std::min(position, text.size());
+        }
+        break;
+    }
+
+    if (error != nullptr) *error = "missing \"p sp <vertices> <arcs>\" problem line";
+    return std::string_view::npos;
+}
+
+std::size_t parseMatrixHeader(std::string_view text, int& vertexCount, MatrixHeader& header,
+                              std::string* error) {
+    auto fail = [error](const char* message) {
+        if (error != nullptr) *error = message;
+        return std::string_view::npos;
+    };
+
+    std::size_t newline = std::min(text.find('\n', 0), text.size());
+    Tokens banner(text.substr(0, newline));
+    if (banner.next() != "%%MatrixMarket" || lowercase(banner.next()) != "matrix" ||
+        lowercase(banner.next()) != "coordinate")
+        return fail("not a %%MatrixMarket matrix coordinate file");
+
+    std::string field = lowercase(banner.next());
+    std::string symmetry = lowercase(banner.next());
+    if (field == "pattern")
+        header.weighted = false;
+    else if (field != "real" && field != "double" && field != "integer")
+        return fail("only real, integer and pattern matrices can be imported");
+
+    if (symmetry == "symmetric") {
+        header.mirrored = true;
+    } else if (symmetry == "skew-symmetric") {
+        // a pattern has no values to negate, the format doesn't allow the pair
+        if (!header.weighted) return fail("pattern matrices can't be skew-symmetric");
+        header.mirrored = true;
+        header.negateMirror = true;
+    } else if (symmetry != "general") {
+        return fail("only general, symmetric and skew-symmetric matrices can be imported");
+    }
+
+    std::size_t position = newline + 1;
+    while (position < text.size()) {
+        newline = std::min(text.find('\n', position), text.size());
+        Tokens tokens(text.substr(position, newline - position));
+        std::string_view first = tokens.next();
+        position = newline + 1;
+
+        if (first.empty() || isComment(first, '%')) continue;
+
+        long long rows, columns, entries;
+        if (!parseInteger(first, rows) || !parseInteger(tokens.next(), columns) ||
+            !parseInteger(tokens.next(), entries) || rows < 0 || columns < 0 ||
+            std::max(rows, columns) >= std::numeric_limits<int>::max())
+            break;
+
+        vertexCount = static_cast<int>(std::max(rows, columns));
+        return std::min(position, text.size());
+    }
+
+    return fail("missing \"<rows> <columns> <entries>\" size line");
+}
+
+// Parses one line of an edge list, Dimacs or Matrix Market body and calls emit(from, to, weight)
+// for each edge it stands for, weight nullopt when unweighted. vertexCount is -1 for edge lists.
+// nullptr or what is wrong with the line.
+template <typename Emit>
+const char* parseEdgeLine(ImportFormat format, std::string_view line, int vertexCount,
+                          const MatrixHeader& matrix, Emit emit) {
+    Tokens tokens(line);
+    std::string_view first = tokens.next();
+    int from, to;
+
+    switch (format) {
+        case ImportFormat::EdgeList: {
+            if (first.empty() || isComment(first, '#') || isComment(first, '%')) return nullptr;
+            if (!parseVertex(first, 0, from) || !parseVertex(tokens.next(), 0, to))
+                return "expected \"<from> <to> [weight]\" with non-negative ids";
+
+            std::optional<Weight> weight;
+            if (std::string_view token = tokens.next(); !token.empty()) {
+                weight = parseWeight(token);
+                if (!weight.has_value()) return "weight is not a finite number";
+            }
+            if (!tokens.next().empty()) return "unexpected text after the weight";
+            emit(from, to, weight);
+            return nullptr;
+        }
+        case ImportFormat::Dimacs: {
+            if (first.empty() || first == "c") return nullptr;
+            if (first != "a") return "expected an \"a <from> <to> <weight>\" arc";
+            if (!parseVertex(tokens.next(), 1, from) || !parseVertex(tokens.next(), 1, to))
+                return "expected an \"a <from> <to> <weight>\" arc";
+            if (from >= vertexCount || to >= vertexCount)
+                return "vertex id above the count in the problem line";
+
+            auto weight = parseWeight(tokens.next());
+            if (!weight.has_value()) return "weight is not a finite number";
+            emit(from, to, weight);
+            return nullptr;
+        }
+        case ImportFormat::MatrixMarket: {
+            if (first.empty() || isComment(first, '%')) return nullptr;
+            if (!parseVertex(first, 1, from) || !parseVertex(tokens.next(), 1, to))
+                return "expected \"<row> <column> [value]\"";
+            if (from >= vertexCount || to >= vertexCount) return "entry outside the matrix size";
+
+            std::optional<Weight> weight;
+            if (matrix.weighted) {
+                weight = parseWeight(tokens.next());
+                if (!weight.has_value()) return "value is not a finite number";
+            }
+            emit(from, to, weight);
+            if (matrix.mirrored && from != to) {
+                if (matrix.negateMirror && weight.has_value()) weight = negate(*weight);
+                emit(to, from, weight);
+            }
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+// DIMACS .co files list "v id x y" with integer coordinates, usually longitude and latitude
+bool readCoordinates(const std::string& path, int vertexCount, int threadCount,
+                     std::vector<CoordinateChunk>& chunks) {
+    auto file = MappedFile::open(path);
+    if (!file.has_value()) return false;
+
+    return parseLines(
+        file->text(), 0, threadCount, chunks,
+        [vertexCount](std::string_view line, CoordinateChunk& chunk) -> const char* {
+            Tokens tokens(line);
+            std::string_view kind = tokens.next();
+            if (kind != "v") return nullptr;
+
+            int vertex;
+            long long x, y;
+            if (!parseVertex(tokens.next(), 1, vertex) || vertex >= vertexCount ||
+                !parseInteger(tokens.next(), x) || !parseInteger(tokens.next(), y))
+                return "expected \"v <id> <x> <y>\"";
+            chunk.coordinates.push_back(
+                {vertex, {static_cast<float>(x), static_cast<float>(y)}});
+            return nullptr;
+        },
+        nullptr);
+}
+
+}  // namespace
+
+ImportFormat importFormatFor(const std::string& path) {
+    auto endsWith = [&path](std::string_view suffix) {
+        return path.size() >= suffix.size() &&
+               lowercase(std::string_view(path).substr(path.size() - suffix.size())) == suffix;
+    };
+
+    if (endsWith(".gr")) return ImportFormat::Dimacs;
+    if (endsWith(".mtx")) return ImportFormat::MatrixMarket;
+    return ImportFormat::EdgeList;
+}
+
+bool importGraph(const std::string& path, ImportFormat format, GraphStore& store,
+                 const ImportOptions& options, std::string* error) {
+    auto file = MappedFile::open(path);
+    if (!file.has_value()) {
+        if (error != nullptr) *error = "can't open " + path;
+        return false;
+    }
+
+    const std::string_view text = file->text();
+    const int threadCount = resolveThreadCount(options.threadCount);
+
+    // -1 when the largest id decides
+    int vertexCount = -1;
+    std::size_t bodyStart = 0;
+    MatrixHeader matrix;
+    if (format == ImportFormat::Dimacs)
+        bodyStart = parseDimacsHeader(text, vertexCount, error);
+    else if (format == ImportFormat::MatrixMarket)
+        bodyStart = parseMatrixHeader(text, vertexCount, matrix, error);
+    if (bodyStart == std::string_view::npos) return false;
+
+    // the first pass only validates and counts, so the second can write every edge straight into
+    // its place in the store's edge list and nothing holds a parsed copy of the edges
+    auto parseWith = [&](auto& locals, auto emitInto) {
+        return parseLines(
+            text, bodyStart, threadCount, locals,
+            [&](std::string_view line, auto& local) {
+                return parseEdgeLine(format, line, vertexCount, matrix,
+                                     [&](int from, int to, const std::optional<Weight>& weight) {
+                                         emitInto(local, from, to, weight);
+                                     });
+            },
+            error);
+    };
+
+    std::vector<EdgeCount> counts;
+    if (!parseWith(counts, [](EdgeCount& count, int from, int to, const std::optional<Weight>&) {
+            ++count.edges;
+            count.maxVertex = std::max({count.maxVertex, from, to});
+        }))
+        return false;
+
+    std::size_t edgeCount = 0;
+    for (const EdgeCount& count : counts) edgeCount += count.edges;
+    // edge ids are ints
+    const int idsLeft = std::numeric_limits<int>::max() - Edge::instanceCounter;
+    if (edgeCount >= static_cast<std::size_t>(idsLeft)) {
+        if (error != nullptr) *error = "too many edges";
+        return false;
+    }
+
+    if (vertexCount == -1) {
+        vertexCount = 0;
+        for (const EdgeCount& count : counts)
+            vertexCount = std::max(vertexCount, count.maxVertex + 1);
+    }
+
+    // default layout, a square grid filled row by row
+    int side = 1;
+    while (static_cast<long long>(side) * side < vertexCount) ++side;
+    std::vector<Vector2> positions(vertexCount);
+    for (int v = 0; v < vertexCount; ++v)
+        positions[v] = {(v % side + 1) * options.spacing, (v / side + 1) * options.spacing};
+
+    if (format == ImportFormat::Dimacs) {
+        // roads.gr takes its coordinates from roads.co
+        std::string coordinatePath = importFormatFor(path) == ImportFormat::Dimacs
+                                         ? path.substr(0, path.size() - 3) + ".co"
+                                         : path + ".co";
+        std::vector<CoordinateChunk> coordinates;
+        if (readCoordinates(coordinatePath, vertexCount, threadCount, coordinates)) {
+            // scaled into the square the grid would take, y flipped so north stays up
+            float minX = std::numeric_limits<float>::max();
+            float maxX = std::numeric_limits<float>::lowest();
+            float minY = minX, maxY = maxX;
+            for (const auto& chunk : coordinates) {
+                for (const auto& [vertex, pos] : chunk.coordinates) {
+                    minX = std::min(minX, pos.x);
+                    maxX = std::max(maxX, pos.x);
+                    minY = std::min(minY, pos.y);
+                    maxY = std::max(maxY, pos.y);
+                }
+            }
+
+            float extent = std::max({maxX - minX, maxY - minY, 1.0f});
+            float scale = side * options.spacing / extent;
+            for (const auto& chunk : coordinates) {
+                for (const auto& [vertex, pos] : chunk.coordinates)
+                    positions[vertex] = {options.spacing + (pos.x - minX) * scale,
+                                         options.spacing + (maxY - pos.y) * scale};
+            }
+        }
+    }
+
+    std::vector<Vertex> vertices;
+    vertices.reserve(vertexCount);
+    for (int v = 0; v < vertexCount; ++v)
+        vertices.emplace_back(positions[v], options.radius, options.color,
+                              GraphStore::defaultLabel(v));
+    std::vector<Vector2>().swap(positions);
+
+    // ids follow the file like edges numbered one by one would
+    std::vector<Edge> edges(edgeCount);
+    std::vector<EdgeCursor> cursors(counts.size());
+    for (std::size_t chunk = 0, first = 0; chunk < counts.size(); first += counts[chunk++].edges)
+        cursors[chunk] = {edges.data() + first, Edge::instanceCounter + static_cast<int>(first)};
+    parseWith(cursors, [](EdgeCursor& cursor, int from, int to,
+                          const std::optional<Weight>& weight) {
+        Edge& edge = *cursor.next++;
+        edge.id = cursor.nextId++;
+        edge.fromId = from;
+        edge.toId = to;
+        edge.weighted = weight.has_value();
+        if (weight.has_value()) edge.weight = *weight;
+    });
+
+    store.load(std::move(vertices), std::move(edges));
+    return true;
+}
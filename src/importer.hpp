@@ -0,0 +1,38 @@
+#ifndef IMPORTER_HPP
+#define IMPORTER_HPP
+
+#include <string>
+
+#include "graphstore.hpp"
+#include "types.hpp"
+
+// EdgeList: one "from to [weight]" per line, 0-based ids, lines starting with # or % are comments
+// Dimacs: shortest path challenge .gr files ("p sp n m" then "a from to weight", 1-based). The
+//         vertex coordinates are taken from the .co file next to it when there is one
+// MatrixMarket: coordinate .mtx files, every stored entry (i, j) becomes an edge i -> j (1-based),
+//               symmetric and skew-symmetric matrices also get j -> i, with the value negated
+//               for skew-symmetric ones. pattern skew-symmetric matrices are rejected
+enum class ImportFormat { EdgeList, Dimacs, MatrixMarket };
+
+struct ImportOptions {
+    int threadCount = 0;  // 0 picks the hardware concurrency
+    float radius = 30.0f;
+    Color color{0, 0, 0, 255};
+    // distance between neighbouring vertices of the default layout
+    float spacing = 70.0f;
+};
+
+// .gr is Dimacs, .mtx MatrixMarket, anything else an edge list
+ImportFormat importFormatFor(const std::string& path);
+
+// Replaces the contents of the store with the file. The file is mapped and split into one chunk
+// per thread at line boundaries; each thread parses its chunk in place with from_chars, so no
+// line or token is copied into a string. A first pass validates and counts the edges of every
+// chunk, a second writes them straight into the store's edge list at their chunk's offset, so
+// edge ids follow the file and no parsed copy of the edges is held. Vertices without
+// coordinates are laid out row by row on a square grid. false (store untouched) on unreadable or
+// malformed input, with the reason and line written to error when given.
+bool importGraph(const std::string& path, ImportFormat format, GraphStore& store,
+                 const ImportOptions& options = {}, std::string* error = nullptr);
+
+#endif  // IMPORTER_HPP
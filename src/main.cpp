@@ -1,26 +1,42 @@
 #include <algorithm>
 #include <cctype>
-#include <numeric>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <memory>
 #include <optional>
-#include <regex>
 #include <string>
-#include <unordered_map>
+#include <tuple>
+#include <utility>
 #include <variant>
 #include <vector>
 
+#include "components.hpp"
+#include "contraction.hpp"
 #include "edge.hpp"
+#include "forcelayout.hpp"
+#include "graph.hpp"
+#include "graphfile.hpp"
+#include "graphstore.hpp"
+#include "importer.hpp"
 #include "menuitem.hpp"
+#include "playback.hpp"
+#include "profiler.hpp"
 #include "raylib.h"
+#include "render.hpp"
+#include "traversal.hpp"
 #include "util.hpp"
 #include "vertex.hpp"
+#include "weight.hpp"
 
-int main() {
+int main(int argc, char** argv) {
     constexpr int screenWidth = 800;
     constexpr int screenHeight = 600;
     constexpr int fps = 60;
 
     constexpr float vertexRadius = 30;
     constexpr Color vertexGhostColor = GRAY;
+    constexpr Color vertexBlockedGhostColor = LIGHTGRAY;
     constexpr Color vertexColor = BLACK;
 
     constexpr int fontSizeSmall = 10;
@@ -30,24 +46,110 @@ int main() {
     constexpr int menuItemWidth = 50;
     constexpr int menuItemHeight = 50;
 
-    constexpr double visualisationDelay = 1.0;
+    // steps per second, the last one plays as fast as the frame allows
+    constexpr double playbackSpeeds[] = {0.5, 1,   2,   4,    8,   16,
+                                         32,  128, 512, 2048, 8192, Playback::unlimitedSpeed};
+    constexpr int playbackSpeedCount = sizeof(playbackSpeeds) / sizeof(playbackSpeeds[0]);
     constexpr double afterVisualisationWaitTime = 5.0;
+    constexpr Rectangle progressBar{5, screenHeight - 20, screenWidth - 10, 10};
     constexpr Color currentVertexColor = RED;
     constexpr Color toVisitVertexColor = YELLOW;
 
     constexpr float edgeLineThickness = 2.0;
 
+    // straight-line distance one unit of edge weight stands for in A*, as multiples of the
+    // smallest unit that keeps its paths exact. Below 1 the guidance overestimates and trades
+    // exact paths for fewer expansions, the last one turns it off
+    constexpr double aStarUnitScales[] = {0.125, 0.25, 0.5, 1, 2, 4, INFINITY};
+    constexpr int aStarUnitScaleCount = sizeof(aStarUnitScales) / sizeof(aStarUnitScales[0]);
+
+    // wheel notches scale the zoom by zoomStep
+    constexpr float minZoom = 0.0005f;
+    constexpr float maxZoom = 8.0f;
+    constexpr float zoomStep = 1.2f;
+    // level of detail, in screen pixels: vertices smaller than pointRadius become pointSize
+    // squares, labels and weights need vertices of at least labelRadius
+    constexpr float pointRadius = 2.0f;
+    constexpr float pointSize = 2.0f;
+    constexpr float labelRadius = 10.0f;
+    // edges are merged per pair of aggregateCell sized screen cells once vertices are points or
+    // more than edgeBudget edges are in view
+    constexpr float aggregateCell = 4.0f;
+    constexpr size_t edgeBudget = 20000;
+
+    // The frame profiler's phases. Input includes whatever a click starts, the adjacency build
+    // and first step of a search too; search is the playback, which runs the traversal as it
+    // goes; vertices, edges and labels are only spent when the static layer is redrawn; frame is
+    // everything up to present, which is mostly the wait for the frame rate cap.
+    enum ProfilePhase {
+        InputPhase,
+        LayoutPhase,
+        AdjacencyPhase,
+        SearchPhase,
+        VerticesPhase,
+        EdgesPhase,
+        LabelsPhase,
+        MenuPhase,
+        HudPhase,
+        FramePhase,
+        PresentPhase
+    };
+    // ctrl+p starts and stops writing every frame's phase times here
+    const std::string profileCapturePath = "graphiz_profile.csv";
+
     Action currentAction = Action::Default;
 
+    // mouse position in graph coordinates, the menu and overlays use screen coordinates
     float mouseX{}, mouseY{};
+    Camera2D camera{{0, 0}, {0, 0}, 0, 1};
+
+    // opened on start when it exists, ctrl+s saves to it and ctrl+o reverts to it. Any other
+    // file given is imported instead and saved next to it as .gphz
+    std::filesystem::path graphPath = argc > 1 ? argv[1] : "graph.gphz";
+    // shown at the bottom of the window until statusUntil
+    std::string statusText;
+    double statusUntil = 0;
 
-    std::vector<Vertex> vertices;
-    std::vector<Vertex> vertices_copy;
+    FrameProfiler profiler({"input", "layout", "adjacency", "search", "vertices", "edges", "labels",
+                            "menu", "hud", "frame", "present"});
 
-    std::vector<Edge> edges;
+    GraphStore store;
+    // ctrl+l toggles it, edits restart it from the current positions
+    ForceLayout layout;
+    bool layoutEnabled = false;
+    // ctrl+h toggles it, rebuilt in the background after every edit unless a weight is negative;
+    // once it matches the graph it answers Dijkstra queries to a clicked target and A* queries
+    // are timed against it
+    HierarchyBuilder hierarchy;
+    bool hierarchyEnabled = false;
+    // the query engine for the hierarchy it was made for, replaced when a newer one is built
+    std::shared_ptr<const ContractionHierarchy> queriedHierarchy;
+    std::optional<HierarchyQuery> hierarchyQuery;
+    // ctrl+u steps through aStarUnitScales, the next A* search picks it up
+    int aStarUnitScale = 3;
+    // ctrl+c colours the weakly connected components, then the strongly connected ones, then
+    // resets the colours
+    enum { NoComponents, WeakComponents, StrongComponents } componentColoring = NoComponents;
+    if (graphPath.extension() == ".gphz") {
+        loadGraph(graphPath.string(), store);
+    } else {
+        ImportOptions options;
+        options.radius = vertexRadius;
+        options.color = vertexColor;
+        std::string error;
+        statusText = importGraph(graphPath.string(), importFormatFor(graphPath.string()), store,
+                                 options, &error)
+                         ? "Imported " + graphPath.string()
+                         : "Could not import " + graphPath.string() + ": " + error;
+        statusUntil = 5;
+        graphPath.replace_extension(".gphz");
+    }
+    const std::vector<Vertex>& vertices = store.vertices();
+
+    const std::vector<Edge>& edges = store.edges();
     Vector2 edgeStart, edgeEnd;
 
-    std::unordered_map<std::string, std::vector<std::string>> adjacencyMap;
+    const Graph* graph = nullptr;
 
     bool mouseDown = false;
     bool actionSet = false;
@@ -59,14 +161,33 @@ int main() {
     Vector2 moveStart, moveEnd;
 
     int pressedKey{};
+    std::vector<Vector2> edgeSegments;
+    std::vector<Vector2> aggregatedSegments;
+    std::vector<Vector2> points;
+    std::vector<Color> pointColors;
+    // screen cells of pointSize that already have a point this frame
+    std::vector<bool> pointCovered;
+    // labels and weights are laid out once per text and drawn together at the end of a pass
+    LabelCache vertexLabels(fontSizeRegular);
+    LabelCache weightLabels(fontSizeRegular);
+    TextBatch textBatch;
+    int vertexToDelete = -1;
+    int edgeToDelete = -1;
+    // text typed into the selected edge's weight, stored whenever it parses
+    std::string weightDraft;
+    int weightDraftEdge = -1;
 
     bool searching = false;
-    std::vector<std::string> searchTraverseOrder;
-    std::map<std::string, std::pair<std::map<std::string, int>, std::map<std::string, int>>>
-        dijkstraSearchTraverseOrder;
-
-    std::unordered_map<std::string, Vertex*> vertexMap;
-    bool initmap = false;
+    // visits are pulled from the traversal as playback reaches them
+    std::optional<Playback> playback;
+    int playbackSpeed = 1;
+    // time spent on the last step, the visualisation closes after afterVisualisationWaitTime
+    double finishedFor = 0;
+    // what Dijkstra takes off its queue for the A* query, A*'s own count is the playback position
+    DijkstraExpansionCounter dijkstraExpansions;
+    // the same query on the hierarchy, negative time when there was no current one
+    double hierarchyDistance = 0;
+    double hierarchyMicroseconds = -1;
 
     std::vector<MenuItem> menuItems{
         {{0, screenHeight / 2.0 - (4 * menuItemHeight), menuItemWidth, menuItemHeight},
@@ -99,89 +220,481 @@ int main() {
         {{0, screenHeight / 2.0 + (3 * menuItemHeight), menuItemWidth, menuItemHeight},
          MAROON,
          Action::Dijkstra,
+         false},
+        {{0 + menuItemWidth, screenHeight / 2.0 + (3 * menuItemHeight), menuItemWidth,
+          menuItemHeight},
+         ORANGE,
+         Action::AStar,
          false}};
 
-    InitWindow(screenWidth, screenHeight, "graphiz");
-    SetTargetFPS(fps);
+    // queued on textBatch, centred on the vertex
+    auto addVertexLabel = [&](const Vertex& vertex) {
+        const GlyphRun& run = vertexLabels.get(vertex.id, vertex.label);
+        textBatch.add(run, {vertex.pos.x - run.width / 2.0f, vertex.pos.y - 5}, WHITE);
+    };
 
-    while (!WindowShouldClose()) {
-        if (searching) {
-            if (currentAlgorithm == Algorithm::BFS || currentAlgorithm == Algorithm::DFS) {
-                if (vertices_copy.size() == 0) {
-                    vertices_copy = vertices;
-                }
+    // frames the whole graph when it doesn't fit the default view, small graphs keep that one
+    auto fitCamera = [&] {
+        camera = {{0, 0}, {0, 0}, 0, 1};
 
-                BeginDrawing();
-                ClearBackground(WHITE);
+        float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+        for (const Vertex& vertex : vertices) {
+            if (!vertex.usable) continue;
+            minX = std::min(minX, vertex.pos.x - vertex.radius);
+            minY = std::min(minY, vertex.pos.y - vertex.radius);
+            maxX = std::max(maxX, vertex.pos.x + vertex.radius);
+            maxY = std::max(maxY, vertex.pos.y + vertex.radius);
+        }
+        if (minX > maxX ||
+            (minX >= 0 && minY >= 0 && maxX <= screenWidth && maxY <= screenHeight))
+            return;
 
-                for (auto& vertex : vertices_copy) {
-                    if (vertex.usable) {
-                        if (vertex.visited)
-                            DrawCircle(vertex.pos.x, vertex.pos.y, vertex.radius, GREEN);
-                        else
-                            DrawCircle(vertex.pos.x, vertex.pos.y, vertex.radius, vertex.color);
-                        if (!vertex.label.empty()) {
-                            int textWidth = MeasureText(vertex.label.c_str(), fontSizeRegular);
-                            DrawText(vertex.label.c_str(), vertex.pos.x - textWidth / 2.0,
-                                     vertex.pos.y - 5, fontSizeRegular, WHITE);
-                        }
-                        if (!initmap) vertexMap[vertex.label] = &vertex;
-                    }
+        camera.offset = {screenWidth / 2.0f, screenHeight / 2.0f};
+        camera.target = {(minX + maxX) / 2, (minY + maxY) / 2};
+        camera.zoom = std::clamp(
+            0.9f * std::min(screenWidth / (maxX - minX), screenHeight / (maxY - minY)), minZoom,
+            maxZoom);
+    };
+
+    // the wheel zooms around the cursor, dragging with the right button pans
+    auto updateCamera = [&] {
+        Vector2 mouse = GetMousePosition();
+        if (float wheel = GetMouseWheelMove(); wheel != 0) {
+            camera.target = GetScreenToWorld2D(mouse, camera);
+            camera.offset = mouse;
+            camera.zoom = std::clamp(camera.zoom * std::pow(zoomStep, wheel), minZoom, maxZoom);
+        }
+        if (IsMouseButtonDown(MOUSE_BUTTON_RIGHT)) {
+            Vector2 delta = GetMouseDelta();
+            camera.target.x -= delta.x / camera.zoom;
+            camera.target.y -= delta.y / camera.zoom;
+        }
+    };
+
+    // Draws what the camera sees, call between BeginMode2D and EndMode2D. Vertices and edges come
+    // from spatial index queries on the view and get cheaper as they shrink on screen, so a frame
+    // costs what is visible rather than the size of the graph. marks colors the vertices during
+    // a search, without them the weights are drawn too.
+    auto drawGraph = [&](const std::vector<VertexMark>* marks, float edgeThickness) {
+        const float zoom = camera.zoom;
+        const Vector2 topLeft = GetScreenToWorld2D({0, 0}, camera);
+        const Rectangle view{topLeft.x, topLeft.y, screenWidth / zoom, screenHeight / zoom};
+
+        const std::vector<int> visibleVertices = store.spatialIndex().verticesIn(view);
+        const std::vector<int> visibleEdges = store.spatialIndex().edgesIn(view);
+        const bool aggregateEdges =
+            vertexRadius * zoom < pointRadius || visibleEdges.size() > edgeBudget;
+
+        auto colorOf = [&](const Vertex& vertex) {
+            if (marks == nullptr) return vertex.color;
+            VertexMark mark = (*marks)[vertex.id];
+            return mark == VertexMark::Visited    ? GREEN
+                   : mark == VertexMark::Frontier ? toVisitVertexColor
+                                                  : vertex.color;
+        };
+
+        ProfileTimer vertexTimer(profiler, VerticesPhase);
+        // one point per screen cell is enough, whatever else lands there is hidden anyway
+        const int columns = static_cast<int>(screenWidth / pointSize);
+        const int rows = static_cast<int>(screenHeight / pointSize);
+        pointCovered.assign(static_cast<size_t>(columns) * rows, false);
+        points.clear();
+        pointColors.clear();
+        for (int id : visibleVertices) {
+            const Vertex& vertex = store.vertex(id);
+            if (vertex.radius * zoom >= pointRadius) {
+                DrawCircle(vertex.pos.x, vertex.pos.y, vertex.radius, colorOf(vertex));
+                continue;
+            }
+
+            int column = static_cast<int>(
+                ((vertex.pos.x - camera.target.x) * zoom + camera.offset.x) / pointSize);
+            int row = static_cast<int>(
+                ((vertex.pos.y - camera.target.y) * zoom + camera.offset.y) / pointSize);
+            if (column >= 0 && column < columns && row >= 0 && row < rows) {
+                size_t cell = static_cast<size_t>(row) * columns + column;
+                if (pointCovered[cell]) continue;
+                pointCovered[cell] = true;
+            }
+            points.push_back(vertex.pos);
+            pointColors.push_back(colorOf(vertex));
+        }
+        drawPointBatch(points, pointColors, pointSize / zoom);
+        vertexTimer.stop();
+
+        ProfileTimer edgeTimer(profiler, EdgesPhase);
+        edgeSegments.clear();
+        for (int edgeId : visibleEdges) {
+            const Edge& edge = *store.findEdge(edgeId);
+            // endpoint ids index the vertex list directly, no search needed
+            const Vertex& fromVertex = store.vertex(edge.fromId);
+            const Vertex& toVertex = store.vertex(edge.toId);
+            if (fromVertex.usable && toVertex.usable) {
+                edgeSegments.push_back(fromVertex.pos);
+                edgeSegments.push_back(toVertex.pos);
+            }
+        }
+        // lines stay at least a pixel wide however far out the view is
+        if (aggregateEdges) {
+            aggregateSegments(edgeSegments, view, aggregateCell / zoom, aggregatedSegments);
+            drawLineBatch(aggregatedSegments, 1 / zoom, BLACK);
+        } else {
+            drawLineBatch(edgeSegments, std::max(edgeThickness, 1 / zoom), BLACK);
+        }
+        edgeTimer.stop();
+
+        ProfileTimer labelTimer(profiler, LabelsPhase);
+        // weights are drawn after all lines so no line crosses a weight box
+        if (marks == nullptr && vertexRadius * zoom >= labelRadius && !aggregateEdges) {
+            for (int edgeId : visibleEdges) {
+                const Edge& edge = *store.findEdge(edgeId);
+                const Vertex& fromVertex = store.vertex(edge.fromId);
+                const Vertex& toVertex = store.vertex(edge.toId);
+                if (edge.weighted && fromVertex.usable && toVertex.usable) {
+                    int midX = (fromVertex.pos.x + toVertex.pos.x) / 2;
+                    int midY = (fromVertex.pos.y + toVertex.pos.y) / 2;
+                    const GlyphRun& run = weightLabels.get(
+                        edge.id, edge.id == weightDraftEdge ? weightDraft : edge.weight.toString());
+                    DrawRectangle(midX - 5, midY - 5, run.width + 10, 20, BLACK);
+                    textBatch.add(run, {static_cast<float>(midX), static_cast<float>(midY)},
+                                  WHITE);
                 }
-                if (!initmap) initmap = true;
+            }
+        }
 
-                if (!edges.empty()) {
-                    for (const auto& edge : edges) {
-                        // unoptimized
-                        auto fromVertex = std::find_if(
-                            vertices.begin(), vertices.end(),
-                            [&edge](const Vertex& vertex) { return edge.fromId == vertex.id; });
-                        auto toVertex = std::find_if(
-                            vertices.begin(), vertices.end(),
-                            [&edge](const Vertex& vertex) { return edge.toId == vertex.id; });
-                        if (fromVertex->usable && toVertex->usable) {
-                            DrawLineEx({fromVertex->pos.x, fromVertex->pos.y},
-                                       {toVertex->pos.x, toVertex->pos.y}, 3.0, BLACK);
-                            if (!fromVertex->label.empty()) {
-                                int textWidth =
-                                    MeasureText(fromVertex->label.c_str(), fontSizeRegular);
-                                DrawText(fromVertex->label.c_str(),
-                                         fromVertex->pos.x - textWidth / 2.0, fromVertex->pos.y - 5,
-                                         fontSizeRegular, WHITE);
-                            }
-                            if (!toVertex->label.empty()) {
-                                int textWidth =
-                                    MeasureText(toVertex->label.c_str(), fontSizeRegular);
-                                DrawText(toVertex->label.c_str(), toVertex->pos.x - textWidth / 2.0,
-                                         toVertex->pos.y - 5, fontSizeRegular, WHITE);
-                            }
-                        }
-                    }
+        // labels go last so lines don't cover them
+        for (int id : visibleVertices) {
+            const Vertex& vertex = store.vertex(id);
+            if (vertex.radius * zoom >= labelRadius) addVertexLabel(vertex);
+        }
+        textBatch.draw();
+    };
+
+    // also shows the search sub-items while Search is the current action
+    auto drawMenuBar = [&] {
+        for (const auto& menuItem : menuItems) {
+            if (menuItem.visible) {
+                switch (menuItem.action) {
+                    case Action::Details:
+                        DrawRectangleLines(menuItem.rect.x, menuItem.rect.y, menuItemWidth,
+                                           menuItemHeight, menuItem.color);
+                        DrawText(detailsOpen ? "ON" : "OFF", menuItem.rect.x + 15,
+                                 menuItem.rect.y + menuItemHeight / 2.0 - 6, fontSizeRegular,
+                                 BLACK);
+                        break;
+                    case Action::Default:
+                        DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
+                                      menuItem.rect.height, menuItem.color);
+                        DrawLine(menuItem.rect.x + 35, menuItem.rect.y + 35,
+                                 menuItem.rect.x + 15, menuItem.rect.y + 15, BLACK);
+                        DrawLine(menuItem.rect.x + 15, menuItem.rect.y + 15,
+                                 menuItem.rect.x + 30, menuItem.rect.y + 20, BLACK);
+                        DrawLine(menuItem.rect.x + 15, menuItem.rect.y + 15,
+                                 menuItem.rect.x + 20, menuItem.rect.y + 30, BLACK);
+                        if (currentAction == Action::Default)
+                            DrawRectangleLinesEx(
+                                {
+                                    menuItem.rect.x,
+                                    menuItem.rect.y,
+                                    menuItemWidth,
+                                    menuItemHeight,
+                                },
+                                edgeLineThickness + 1, BLACK);
+                        break;
+                    case Action::Vertex:
+                        DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
+                                      menuItem.rect.height, menuItem.color);
+                        DrawCircle(menuItem.rect.x + menuItemWidth / 2.0,
+                                   menuItem.rect.y + menuItemHeight / 2.0, 10, BLACK);
+                        if (currentAction == Action::Vertex)
+                            DrawRectangleLinesEx(
+                                {
+                                    menuItem.rect.x,
+                                    menuItem.rect.y,
+                                    menuItemWidth,
+                                    menuItemHeight,
+                                },
+                                edgeLineThickness + 1, BLACK);
+                        break;
+                    case Action::Edge:
+                        DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
+                                      menuItem.rect.height, menuItem.color);
+                        DrawLine(menuItem.rect.x + 35, menuItem.rect.y + 35,
+                                 menuItem.rect.x + 15, menuItem.rect.y + 15, BLACK);
+                        if (currentAction == Action::Edge)
+                            DrawRectangleLinesEx(
+                                {
+                                    menuItem.rect.x,
+                                    menuItem.rect.y,
+                                    menuItemWidth,
+                                    menuItemHeight,
+                                },
+                                edgeLineThickness + 1, BLACK);
+                        break;
+                    case Action::WeightedEdge:
+                        DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
+                                      menuItem.rect.height, menuItem.color);
+                        DrawLine(menuItem.rect.x + 35, menuItem.rect.y + 35,
+                                 menuItem.rect.x + 15, menuItem.rect.y + 15, BLACK);
+                        DrawText("W", menuItem.rect.x + 27, menuItem.rect.y + 15, fontSizeSmall,
+                                 BLACK);
+                        if (currentAction == Action::WeightedEdge)
+                            DrawRectangleLinesEx(
+                                {
+                                    menuItem.rect.x,
+                                    menuItem.rect.y,
+                                    menuItemWidth,
+                                    menuItemHeight,
+                                },
+                                edgeLineThickness + 1, BLACK);
+                        break;
+                    case Action::Search:
+                        DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
+                                      menuItem.rect.height, menuItem.color);
+                        DrawText("Search", menuItem.rect.x + 6,
+                                 menuItem.rect.y + menuItemHeight / 2.0 - 5, fontSizeSmall,
+                                 BLACK);
+
+                        if (currentAction == Action::Search)
+                            DrawRectangleLinesEx(
+                                {
+                                    menuItem.rect.x,
+                                    menuItem.rect.y,
+                                    menuItemWidth,
+                                    menuItemHeight,
+                                },
+                                edgeLineThickness + 1, BLACK);
+                        // the algorithms stay open while A* waits for its target
+                        for (MenuItem& item : menuItems)
+                            if (item.action == Action::BFS || item.action == Action::DFS ||
+                                item.action == Action::Dijkstra || item.action == Action::AStar)
+                                item.visible = currentAction == Action::Search ||
+                                               currentAction == Action::AStar;
+                        break;
+                    case Action::BFS:
+                        DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
+                                      menuItem.rect.height, menuItem.color);
+                        DrawText("BFS", menuItem.rect.x + 15,
+                                 menuItem.rect.y + menuItemHeight / 2.0 - 5, fontSizeRegular,
+                                 BLACK);
+                        break;
+                    case Action::DFS:
+                        DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
+                                      menuItem.rect.height, menuItem.color);
+                        DrawText("DFS", menuItem.rect.x + 15,
+                                 menuItem.rect.y + menuItemHeight / 2.0 - 5, fontSizeRegular,
+                                 BLACK);
+                        break;
+                    case Action::Dijkstra:
+                        DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
+                                      menuItem.rect.height, menuItem.color);
+                        DrawText("DIJ", menuItem.rect.x + 15,
+                                 menuItem.rect.y + menuItemHeight / 2.0 - 5, fontSizeRegular,
+                                 BLACK);
+                        break;
+                    case Action::AStar:
+                        DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
+                                      menuItem.rect.height, menuItem.color);
+                        DrawText("A*", menuItem.rect.x + 18,
+                                 menuItem.rect.y + menuItemHeight / 2.0 - 5, fontSizeRegular,
+                                 BLACK);
+                        if (currentAction == Action::AStar)
+                            DrawRectangleLinesEx(
+                                {
+                                    menuItem.rect.x,
+                                    menuItem.rect.y,
+                                    menuItemWidth,
+                                    menuItemHeight,
+                                },
+                                edgeLineThickness + 1, BLACK);
+                        break;
                 }
+            }
+        }
+    };
 
-                auto currentLabel = searchTraverseOrder.front();
-                searchTraverseOrder.erase(searchTraverseOrder.begin());
+    // Everything the static layer shows depends on, it is redrawn when this changes or
+    // staticDirty is set. playbackPosition is -1 outside of a search
+    struct StaticLayerKey {
+        unsigned long drawVersion = 0;
+        float targetX = 0, targetY = 0, offsetX = 0, offsetY = 0, zoom = 0;
+        int playbackPosition = -1;
+        Action action = Action::Default;
+        bool detailsOpen = false;
+        int weightDraftEdge = -1;
+        std::string weightDraft;
 
-                auto vertexWithCurrentLabel = vertexMap[currentLabel];
+        bool operator==(const StaticLayerKey&) const = default;
+    };
+    auto staticLayerKey = [&](int playbackPosition) {
+        return StaticLayerKey{store.drawVersion(),
+                              camera.target.x,
+                              camera.target.y,
+                              camera.offset.x,
+                              camera.offset.y,
+                              camera.zoom,
+                              playbackPosition,
+                              currentAction,
+                              detailsOpen,
+                              weightDraftEdge,
+                              weightDraft};
+    };
 
-                DrawCircle(vertexWithCurrentLabel->pos.x, vertexWithCurrentLabel->pos.y,
-                           vertexWithCurrentLabel->radius, currentVertexColor);
+    // the first visit shows straight away, the rest follow at the chosen speed
+    auto startPlayback = [&](Traversal traversal) {
+        ProfileTimer timer(profiler, SearchPhase);
+        playback.emplace(*graph, std::move(traversal));
+        playback->setSpeed(playbackSpeeds[playbackSpeed]);
+        playback->stepForward();
+    };
 
-                int textWidth = MeasureText(vertexWithCurrentLabel->label.c_str(), fontSizeRegular);
-                DrawText(vertexWithCurrentLabel->label.c_str(),
-                         vertexWithCurrentLabel->pos.x - textWidth / 2.0,
-                         vertexWithCurrentLabel->pos.y - 5, fontSizeRegular, WHITE);
+    // the CSR snapshot a search runs on, only rebuilt after edits
+    auto adjacency = [&](bool weighted) {
+        ProfileTimer timer(profiler, AdjacencyPhase);
+        return weighted ? &store.weightedGraph() : &store.graph();
+    };
 
-                vertexWithCurrentLabel->visited = true;
+    // median and 99th percentile of every phase over the last few seconds, below the details
+    auto drawProfile = [&] {
+        DrawText(profiler.capturing() ? "Frame phases, ms (capturing)" : "Frame phases, ms",
+                 5, 130, fontSizeRegular, BLACK);
+        for (int phase = 0; phase < profiler.phaseCount(); ++phase) {
+            DrawText(TextFormat("%s  p50 %.2f  p99 %.2f", profiler.phaseName(phase).c_str(),
+                                profiler.percentile(phase, 0.5), profiler.percentile(phase, 0.99)),
+                     5, 145 + 15 * phase, fontSizeRegular, BLACK);
+        }
+    };
 
-                for (const auto& [key, values] : adjacencyMap) {
-                    if (key == currentLabel)
-                        for (auto& v : values) {
-                            vertexMap[v]->color = toVisitVertexColor;
-                        }
+    // distance from start to target on the hierarchy and the query time in microseconds, nullopt
+    // unless it is on and was built from the current weighted graph
+    auto queryHierarchy = [&](int start,
+                              int target) -> std::optional<std::pair<double, double>> {
+        auto built = hierarchy.current();
+        if (!hierarchyEnabled || built == nullptr || built->version() != store.version())
+            return std::nullopt;
+        if (built != queriedHierarchy) {
+            queriedHierarchy = built;
+            hierarchyQuery.emplace(*built);
+        }
+        auto begin = std::chrono::steady_clock::now();
+        double distance = hierarchyQuery->shortestPath(start, target, false).distance;
+        return std::pair{distance, std::chrono::duration<double, std::micro>(
+                                       std::chrono::steady_clock::now() - begin)
+                                       .count()};
+    };
+
+    // Runs A* from start to target on the vertex positions and plays it back, while Dijkstra
+    // counts its expansions for the same query on a worker for the HUD to compare.
+    auto startAStar = [&](int start, int target) {
+        graph = adjacency(true);
+        std::vector<Vector2> positions(vertices.size());
+        for (const Vertex& vertex : vertices) positions[vertex.id] = vertex.pos;
+        const double scale = aStarUnitScales[aStarUnitScale];
+        double unit = std::isinf(scale) ? scale : scale * minimumDistanceUnit(*graph, positions);
+        dijkstraExpansions.start(*graph, start, target);
+
+        hierarchyMicroseconds = -1;
+        if (auto answered = queryHierarchy(start, target))
+            std::tie(hierarchyDistance, hierarchyMicroseconds) = *answered;
+        startPlayback(Traversal(std::in_place_type<AStarTraversal>, *graph, std::move(positions),
+                                start, target, unit));
+        currentAlgorithm = Algorithm::AStar;
+        searching = true;
+    };
+
+    fitCamera();
+
+    InitWindow(screenWidth, screenHeight, "graphiz");
+    SetTargetFPS(fps);
+
+    // The graph and the menu bar are drawn into staticLayer only when they change, a frame
+    // otherwise copies it to the screen and draws the overlays (selection, ghost vertex, the edge
+    // being dragged, the current search vertex) on top, so an idle window costs next to nothing
+    RenderTexture2D staticLayer = LoadRenderTexture(screenWidth, screenHeight);
+    StaticLayerKey staticKey;
+    // for edits the key can't see, like labels typed into a vertex
+    bool staticDirty = true;
+    // render textures are stored upside down
+    auto drawStaticLayer = [&] {
+        DrawTextureRec(staticLayer.texture, {0, 0, screenWidth, -screenHeight}, {0, 0}, WHITE);
+    };
+
+    while (!WindowShouldClose()) {
+        ProfileTimer frameTimer(profiler, FramePhase);
+        {
+            ProfileTimer timer(profiler, InputPhase);
+            updateCamera();
+        }
+
+        if (layoutEnabled) {
+            ProfileTimer timer(profiler, LayoutPhase);
+            if (layout.version() != store.topologyVersion()) layout.start(store, true);
+            layout.apply(store);
+        }
+        if (hierarchyEnabled && hierarchy.version() != store.version() &&
+            !hierarchy.rebuild(store.weightedGraph())) {
+            statusText = "Hierarchy skipped, a weight is negative";
+            statusUntil = GetTime() + 3;
+        }
+
+        if (searching) {
+            // seeking runs the traversal as far as it has to, so all of this counts as search
+            ProfileTimer searchTimer(profiler, SearchPhase);
+            if (IsKeyPressed(KEY_SPACE)) playback->setPaused(!playback->isPaused());
+            if (IsKeyPressed(KEY_RIGHT) || IsKeyPressedRepeat(KEY_RIGHT)) {
+                playback->setPaused(true);
+                playback->stepForward();
+            }
+            if (IsKeyPressed(KEY_LEFT) || IsKeyPressedRepeat(KEY_LEFT)) {
+                playback->setPaused(true);
+                playback->stepBack();
+            }
+            if (IsKeyPressed(KEY_HOME)) playback->seek(0);
+            if (IsKeyPressed(KEY_END)) playback->seek(playback->totalSteps());
+            if (IsKeyPressed(KEY_UP) || IsKeyPressed(KEY_DOWN)) {
+                playbackSpeed = std::clamp(playbackSpeed + (IsKeyPressed(KEY_UP) ? 1 : -1), 0,
+                                           playbackSpeedCount - 1);
+                playback->setSpeed(playbackSpeeds[playbackSpeed]);
+            }
+            if (IsMouseButtonDown(MOUSE_BUTTON_LEFT) &&
+                CheckCollisionPointRec(GetMousePosition(), progressBar)) {
+                float fraction = (GetMouseX() - progressBar.x) / progressBar.width;
+                playback->seek(static_cast<int>(std::round(fraction * playback->totalSteps())));
+            }
+
+            playback->update(GetFrameTime());
+            searchTimer.stop();
+
+            StaticLayerKey key = staticLayerKey(playback->position());
+            if (staticDirty || key != staticKey) {
+                BeginTextureMode(staticLayer);
+                ClearBackground(WHITE);
+                BeginMode2D(camera);
+                // the search state is an overlay indexed like the vertex list, vertices stay as
+                // they are
+                drawGraph(&playback->marks(), 3.0);
+                EndMode2D();
+                EndTextureMode();
+                staticKey = key;
+                staticDirty = false;
+            }
+
+            BeginDrawing();
+            drawStaticLayer();
+
+            BeginMode2D(camera);
+            if (auto step = playback->currentStep()) {
+                const Vertex& currentVertex = store.vertex(step->vertex);
+                DrawCircle(currentVertex.pos.x, currentVertex.pos.y, currentVertex.radius,
+                           currentVertexColor);
+                if (currentVertex.radius * camera.zoom >= labelRadius) {
+                    addVertexLabel(currentVertex);
+                    textBatch.draw();
                 }
             }
 
+            EndMode2D();
+
             switch (currentAlgorithm) {
                 case Algorithm::BFS:
                     DrawText("Breadth-first search (BFS)", 5, 5, 20, BLACK);
@@ -195,345 +708,282 @@ int main() {
                     DrawText("Dijkstra", 5, 5, 20, BLACK);
                     DrawText("Time complexity: O(E+V log V)", 5, 25, 20, BLACK);
                     break;
+                case Algorithm::AStar:
+                    DrawText("A* search", 5, 5, 20, BLACK);
+                    DrawText("Time complexity: O(E+V log V)", 5, 25, 20, BLACK);
+                    DrawText(dijkstraExpansions.expanded() >= 0
+                                 ? TextFormat("Expanded %d vertices, Dijkstra %d",
+                                              playback->position(), dijkstraExpansions.expanded())
+                                 : TextFormat("Expanded %d vertices, Dijkstra counting",
+                                              playback->position()),
+                             5, 85, 20, BLACK);
+                    if (hierarchyMicroseconds >= 0)
+                        DrawText(TextFormat("Hierarchy: distance %g in %.1f us",
+                                            hierarchyDistance, hierarchyMicroseconds),
+                                 5, 105, 20, BLACK);
+                    else if (hierarchyEnabled)
+                        DrawText("Hierarchy: building", 5, 105, 20, BLACK);
+                    break;
             }
-            DrawText(TextFormat("Delay: %.2fs", visualisationDelay), 5, 45, 20, BLACK);
+            DrawText(playback->speed() == Playback::unlimitedSpeed
+                         ? "Speed: max"
+                         : TextFormat("Speed: %g steps/s", playback->speed()),
+                     5, 45, 20, BLACK);
+            DrawText(playback->totalKnown() ? TextFormat("Step %d of %d", playback->position(),
+                                                         playback->knownSteps())
+                                            : TextFormat("Step %d", playback->position()),
+                     5, 65, 20, playback->isPaused() ? RED : BLACK);
+            DrawText("space pause, left/right step, up/down speed, home/end seek, enter close", 5,
+                     progressBar.y - 15, fontSizeSmall, DARKGRAY);
 
-            EndDrawing();
-            if (!searchTraverseOrder.empty()) {
-                WaitTime(visualisationDelay);
-            } else {
-                WaitTime(afterVisualisationWaitTime);
-                searching = false;
-                vertexMap.clear();
-                vertices_copy.clear();
-                initmap = false;
+            // the bar is relative to the visits seen so far until the traversal has finished
+            DrawRectangleLinesEx(progressBar, 1, BLACK);
+            if (playback->knownSteps() > 0)
+                DrawRectangle(progressBar.x, progressBar.y,
+                              progressBar.width * playback->position() / playback->knownSteps(),
+                              progressBar.height, BLACK);
+
+            if (detailsOpen) {
+                ProfileTimer timer(profiler, HudPhase);
+                drawProfile();
             }
-        } else {
-            BeginDrawing();
 
-            ClearBackground(WHITE);
+            frameTimer.stop();
+            {
+                ProfileTimer timer(profiler, PresentPhase);
+                EndDrawing();
+            }
 
-            /// Menu bar
+            if (playback->atEnd() && !playback->isPaused())
+                finishedFor += GetFrameTime();
+            else
+                finishedFor = 0;
 
-            for (const auto& menuItem : menuItems) {
-                if (menuItem.visible) {
-                    switch (menuItem.action) {
-                        case Action::Details:
-                            DrawRectangleLines(menuItem.rect.x, menuItem.rect.y, menuItemWidth,
-                                               menuItemHeight, menuItem.color);
-                            DrawText(detailsOpen ? "ON" : "OFF", menuItem.rect.x + 15,
-                                     menuItem.rect.y + menuItemHeight / 2.0 - 6, fontSizeRegular,
-                                     BLACK);
-                            break;
-                        case Action::Default:
-                            DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
-                                          menuItem.rect.height, menuItem.color);
-                            DrawLine(menuItem.rect.x + 35, menuItem.rect.y + 35,
-                                     menuItem.rect.x + 15, menuItem.rect.y + 15, BLACK);
-                            DrawLine(menuItem.rect.x + 15, menuItem.rect.y + 15,
-                                     menuItem.rect.x + 30, menuItem.rect.y + 20, BLACK);
-                            DrawLine(menuItem.rect.x + 15, menuItem.rect.y + 15,
-                                     menuItem.rect.x + 20, menuItem.rect.y + 30, BLACK);
-                            if (currentAction == Action::Default)
-                                DrawRectangleLinesEx(
-                                    {
-                                        menuItem.rect.x,
-                                        menuItem.rect.y,
-                                        menuItemWidth,
-                                        menuItemHeight,
-                                    },
-                                    edgeLineThickness + 1, BLACK);
-                            break;
-                        case Action::Vertex:
-                            DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
-                                          menuItem.rect.height, menuItem.color);
-                            DrawCircle(menuItem.rect.x + menuItemWidth / 2.0,
-                                       menuItem.rect.y + menuItemHeight / 2.0, 10, BLACK);
-                            if (currentAction == Action::Vertex)
-                                DrawRectangleLinesEx(
-                                    {
-                                        menuItem.rect.x,
-                                        menuItem.rect.y,
-                                        menuItemWidth,
-                                        menuItemHeight,
-                                    },
-                                    edgeLineThickness + 1, BLACK);
-                            break;
-                        case Action::Edge:
-                            DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
-                                          menuItem.rect.height, menuItem.color);
-                            DrawLine(menuItem.rect.x + 35, menuItem.rect.y + 35,
-                                     menuItem.rect.x + 15, menuItem.rect.y + 15, BLACK);
-                            if (currentAction == Action::Edge)
-                                DrawRectangleLinesEx(
-                                    {
-                                        menuItem.rect.x,
-                                        menuItem.rect.y,
-                                        menuItemWidth,
-                                        menuItemHeight,
-                                    },
-                                    edgeLineThickness + 1, BLACK);
-                            break;
-                        case Action::WeightedEdge:
-                            DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
-                                          menuItem.rect.height, menuItem.color);
-                            DrawLine(menuItem.rect.x + 35, menuItem.rect.y + 35,
-                                     menuItem.rect.x + 15, menuItem.rect.y + 15, BLACK);
-                            DrawText("W", menuItem.rect.x + 27, menuItem.rect.y + 15, fontSizeSmall,
-                                     BLACK);
-                            if (currentAction == Action::WeightedEdge)
-                                DrawRectangleLinesEx(
-                                    {
-                                        menuItem.rect.x,
-                                        menuItem.rect.y,
-                                        menuItemWidth,
-                                        menuItemHeight,
-                                    },
-                                    edgeLineThickness + 1, BLACK);
-                            break;
-                        case Action::Search:
-                            DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
-                                          menuItem.rect.height, menuItem.color);
-                            DrawText("Search", menuItem.rect.x + 6,
-                                     menuItem.rect.y + menuItemHeight / 2.0 - 5, fontSizeSmall,
-                                     BLACK);
-
-                            if (currentAction == Action::Search) {
-                                DrawRectangleLinesEx(
-                                    {
-                                        menuItem.rect.x,
-                                        menuItem.rect.y,
-                                        menuItemWidth,
-                                        menuItemHeight,
-                                    },
-                                    edgeLineThickness + 1, BLACK);
-                                (menuItems.end() - 1)->visible = true;
-                                (menuItems.end() - 2)->visible = true;
-                                (menuItems.end() - 3)->visible = true;
-                            } else {
-                                (menuItems.end() - 1)->visible = false;
-                                (menuItems.end() - 2)->visible = false;
-                                (menuItems.end() - 3)->visible = false;
-                            }
-                            break;
-                        case Action::BFS:
-                            DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
-                                          menuItem.rect.height, menuItem.color);
-                            DrawText("BFS", menuItem.rect.x + 15,
-                                     menuItem.rect.y + menuItemHeight / 2.0 - 5, fontSizeRegular,
-                                     BLACK);
-                            break;
-                        case Action::DFS:
-                            DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
-                                          menuItem.rect.height, menuItem.color);
-                            DrawText("DFS", menuItem.rect.x + 15,
-                                     menuItem.rect.y + menuItemHeight / 2.0 - 5, fontSizeRegular,
-                                     BLACK);
-                            break;
-                        case Action::Dijkstra:
-                            DrawRectangle(menuItem.rect.x, menuItem.rect.y, menuItem.rect.width,
-                                          menuItem.rect.height, menuItem.color);
-                            DrawText("DIJ", menuItem.rect.x + 15,
-                                     menuItem.rect.y + menuItemHeight / 2.0 - 5, fontSizeRegular,
-                                     BLACK);
-                            break;
-                    }
-                }
+            if (finishedFor >= afterVisualisationWaitTime || IsKeyPressed(KEY_ENTER)) {
+                searching = false;
+                playback.reset();
+                finishedFor = 0;
             }
+        } else {
+            ProfileTimer inputTimer(profiler, InputPhase);
 
-            /// end Menu bar
-
-            //  Draw vertices
-            if (!vertices.empty()) {
-                if (!searching) {
-                    auto v = tryGetVertex(currentSelection);
-                    for (const auto& vertex : vertices) {
-                        if (v.has_value()) {
-                            auto currentVertex = v.value();
-                            if (*currentVertex == vertex) {
-                                DrawRectangleLines(vertex.pos.x - 35, vertex.pos.y - 35, 70, 70,
-                                                   GREEN);
-
-                                pressedKey = GetCharPressed();
-                                std::regex initialLabel("V\\d");
-                                while (pressedKey > 0) {
-                                    if (isprint(pressedKey)) {
-                                        if (std::regex_match(currentVertex->label, initialLabel))
-                                            currentVertex->label.clear();
-                                        currentVertex->label += pressedKey;
-                                    }
-                                    pressedKey = GetCharPressed();
-                                }
-                                if (IsKeyPressed(KEY_BACKSPACE)) {
-                                    if (currentVertex->label.length() > 0)
-                                        currentVertex->label.pop_back();
-                                }
-                                // Memory isn't freed from deleting
-                                // vertices but rather the vertex just becomes
-                                // unusable(hidden), which increases memory usage if a lot of
-                                // vertices are created and "deleted" because edges hold id's of
-                                // vertices and not references because of pointer misalignment
-                                // while using std::vector, might be refactored to be more efficient
-                                if (IsKeyPressed(KEY_X)) {
-                                    if (currentVertex != nullptr) {
-                                        int idToDelete = currentVertex->id;
-                                        vertices[idToDelete].usable = false;
-                                        edges.erase(
-                                            std::remove_if(edges.begin(), edges.end(),
-                                                           [idToDelete](const Edge& edge) {
-                                                               return (edge.toId == idToDelete ||
-                                                                       edge.fromId == idToDelete);
-                                                           }),
-                                            edges.end());
-                                        resetCurrentSelection(currentSelection);
-                                    }
-                                }
-                            }
-                        }
-                        if (vertex.usable) {
-                            DrawCircle(vertex.pos.x, vertex.pos.y, vertex.radius, vertex.color);
-                            if (!vertex.label.empty()) {
-                                int textWidth = MeasureText(vertex.label.c_str(), fontSizeRegular);
-                                DrawText(vertex.label.c_str(), vertex.pos.x - textWidth / 2.0,
-                                         vertex.pos.y - 5, fontSizeRegular, WHITE);
-                            }
-                        }
+            // typing goes to the selected vertex's label or edge's weight
+            if (auto v = tryGetVertex(currentSelection)) {
+                Vertex* currentVertex = v.value();
+                pressedKey = GetCharPressed();
+                while (pressedKey > 0) {
+                    if (isprint(pressedKey)) {
+                        // the first key typed replaces the label the vertex was created with
+                        if (currentVertex->label == GraphStore::defaultLabel(currentVertex->id))
+                            currentVertex->label.clear();
+                        currentVertex->label += pressedKey;
+                        staticDirty = true;
                     }
+                    pressedKey = GetCharPressed();
+                }
+                if (IsKeyPressed(KEY_BACKSPACE)) {
+                    if (currentVertex->label.length() > 0) currentVertex->label.pop_back();
+                    staticDirty = true;
                 }
+                // Deleted vertices leave an unusable slot behind that the next new vertex
+                // reuses, the store is compacted once dead slots outnumber live vertices
+                if (IsKeyPressed(KEY_X)) vertexToDelete = currentVertex->id;
             }
-            // Draw edges
-            if (!edges.empty()) {
-                if (!searching) {
-                    int i = 0;
-                    auto e = tryGetEdge(currentSelection);
-                    for (const auto& edge : edges) {
-                        if (e.has_value()) {
-                            auto currentEdge = e.value();
-                            if (*currentEdge == edge) {
-                                pressedKey = GetCharPressed();
-                                while (pressedKey > 0) {
-                                    if (pressedKey >= 48 && pressedKey <= 57) {
-                                        if (currentEdge->weight == "0") currentEdge->weight.clear();
-                                        currentEdge->weight += pressedKey;
-                                    } else if (pressedKey == 45 && currentEdge->weight.empty()) {
-                                        currentEdge->weight += "-";
-                                    }
-                                    pressedKey = GetCharPressed();
-                                }
-                                if (IsKeyPressed(KEY_BACKSPACE)) {
-                                    if (currentEdge->weight.length() > 0)
-                                        currentEdge->weight.pop_back();
-                                }
-                                if (IsKeyPressed(KEY_X)) {
-                                    if (currentEdge != nullptr) {
-                                        int idToDelete = currentEdge->id;
-                                        edges.erase(std::remove_if(edges.begin(), edges.end(),
-                                                                   [idToDelete](const Edge& edge) {
-                                                                       return edge.id == idToDelete;
-                                                                   }),
-                                                    edges.end());
-                                        resetCurrentSelection(currentSelection);
-                                    }
-                                }
-                            }
-                        }
-                        // unoptimized
-                        auto fromVertex = std::find_if(
-                            vertices.begin(), vertices.end(),
-                            [&edge](const Vertex& vertex) { return edge.fromId == vertex.id; });
-                        auto toVertex = std::find_if(
-                            vertices.begin(), vertices.end(),
-                            [&edge](const Vertex& vertex) { return edge.toId == vertex.id; });
-                        if (fromVertex->usable && toVertex->usable) {
-                            DrawLineEx({fromVertex->pos.x, fromVertex->pos.y},
-                                       {toVertex->pos.x, toVertex->pos.y}, edgeLineThickness,
-                                       BLACK);
-                            if (edge.weighted) {
-                                int midX = (fromVertex->pos.x + toVertex->pos.x) / 2;
-                                int midY = (fromVertex->pos.y + toVertex->pos.y) / 2;
-                                const char* edgeWeight = edge.weight.c_str();
-                                DrawRectangle(midX - 5, midY - 5,
-                                              MeasureText(edgeWeight, fontSizeRegular) + 10, 20,
-                                              BLACK);
-                                DrawText(edgeWeight, midX, midY, fontSizeRegular, WHITE);
-                            }
-                            if (!fromVertex->label.empty()) {
-                                int textWidth =
-                                    MeasureText(fromVertex->label.c_str(), fontSizeRegular);
-                                DrawText(fromVertex->label.c_str(),
-                                         fromVertex->pos.x - textWidth / 2.0, fromVertex->pos.y - 5,
-                                         fontSizeRegular, WHITE);
-                            }
-                            if (!toVertex->label.empty()) {
-                                int textWidth =
-                                    MeasureText(toVertex->label.c_str(), fontSizeRegular);
-                                DrawText(toVertex->label.c_str(), toVertex->pos.x - textWidth / 2.0,
-                                         toVertex->pos.y - 5, fontSizeRegular, WHITE);
-                            }
-                        }
-                        // print edges
-                        if (detailsOpen) {
-                            DrawText(std::to_string(edge.fromId)
-                                         .append(" -> ")
-                                         .append(std::to_string(edge.toId))
-                                         .append(edge.weighted ? " w: " : "")
-                                         .append(edge.weighted ? edge.weight : "")
-                                         .c_str(),
-                                     screenWidth / 2.0, i, fontSizeRegular, RED);
-                            i += 15;
-                        }
+            if (vertexToDelete != -1) {
+                // the vertex's incident edges go with it, and so do their cached weights
+                for (int position : store.outEdges(vertexToDelete))
+                    weightLabels.erase(store.edges()[position].id);
+                for (int position : store.inEdges(vertexToDelete))
+                    weightLabels.erase(store.edges()[position].id);
+                vertexLabels.erase(vertexToDelete);
+                store.removeVertex(vertexToDelete);
+                vertexToDelete = -1;
+                resetCurrentSelection(currentSelection);
+                // nothing is selected now, so no pointer into the store survives this. Edge ids
+                // survive compacting, only the vertex labels are keyed by ids that change
+                if (store.deadVertexCount() > store.vertexCount()) {
+                    store.compact();
+                    vertexLabels.clear();
+                }
+            }
+
+            auto e = tryGetEdge(currentSelection);
+            if (!e.has_value()) weightDraftEdge = -1;
+            if (e.has_value()) {
+                Edge* currentEdge = e.value();
+                if (weightDraftEdge != currentEdge->id) {
+                    weightDraft = currentEdge->weight.toString();
+                    weightDraftEdge = currentEdge->id;
+                }
+                pressedKey = GetCharPressed();
+                while (pressedKey > 0) {
+                    if (pressedKey >= 48 && pressedKey <= 57) {
+                        if (weightDraft == "0") weightDraft.clear();
+                        weightDraft += pressedKey;
+                    } else if (pressedKey == 45 && weightDraft.empty()) {
+                        weightDraft += "-";
+                    } else if (pressedKey == 46 && weightDraft.find('.') == std::string::npos) {
+                        weightDraft += ".";
                     }
+                    pressedKey = GetCharPressed();
+                }
+                if (IsKeyPressed(KEY_BACKSPACE)) {
+                    if (weightDraft.length() > 0) weightDraft.pop_back();
                 }
+                // unfinished input like "-" or "" keeps the last valid weight
+                if (auto weight = Weight::parse(weightDraft))
+                    store.setWeight(currentEdge->id, *weight);
+                if (IsKeyPressed(KEY_X)) edgeToDelete = currentEdge->id;
+            }
+            if (edgeToDelete != -1) {
+                store.removeEdge(edgeToDelete);
+                weightLabels.erase(edgeToDelete);
+                edgeToDelete = -1;
+                resetCurrentSelection(currentSelection);
             }
 
-            mouseX = GetMouseX();
-            mouseY = GetMouseY();
+            Vector2 mouse = GetScreenToWorld2D(GetMousePosition(), camera);
+            mouseX = mouse.x;
+            mouseY = mouse.y;
 
-            if (currentAction == Action::Vertex) {
-                DrawCircle(mouseX, mouseY, vertexRadius, vertexGhostColor);
+            if (IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_S)) {
+                statusText = saveGraph(store, graphPath.string())
+                                 ? "Saved " + graphPath.string()
+                                 : "Could not save " + graphPath.string();
+                statusUntil = GetTime() + 3;
+            } else if (IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_L)) {
+                layoutEnabled = !layoutEnabled;
+                if (layoutEnabled)
+                    layout.start(store);
+                else
+                    layout.stop();
+                statusText = layoutEnabled ? "Layout on" : "Layout off";
+                statusUntil = GetTime() + 3;
+            } else if (IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_C)) {
+                componentColoring = componentColoring == NoComponents     ? WeakComponents
+                                    : componentColoring == WeakComponents ? StrongComponents
+                                                                          : NoComponents;
+                Components components;
+                if (componentColoring == WeakComponents)
+                    components = WeaklyConnectedComponents(*adjacency(false));
+                else if (componentColoring == StrongComponents)
+                    components = StronglyConnectedComponents(*adjacency(false));
+
+                // hues a golden angle apart, neighbouring ids get clearly different colours
+                for (const Vertex& vertex : vertices) {
+                    if (!vertex.usable) continue;
+                    if (componentColoring == NoComponents) {
+                        store.setColor(vertex.id, vertexColor);
+                        continue;
+                    }
+                    float hue = std::fmod(components.component[vertex.id] * 137.508f, 360.0f);
+                    store.setColor(vertex.id, ColorFromHSV(hue, 0.75f, 0.85f));
+                }
+                // dead slots are isolated in the snapshot and count as components of their own
+                int count = components.count - store.deadVertexCount();
+                statusText = componentColoring == WeakComponents
+                                 ? TextFormat("%d weakly connected components", count)
+                             : componentColoring == StrongComponents
+                                 ? TextFormat("%d strongly connected components", count)
+                                 : "Colours reset";
+                statusUntil = GetTime() + 3;
+                staticDirty = true;
+            } else if (IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_H)) {
+                hierarchyEnabled = !hierarchyEnabled;
+                bool built = true;
+                if (hierarchyEnabled) {
+                    built = hierarchy.rebuild(store.weightedGraph());
+                } else {
+                    hierarchy.stop();
+                    hierarchyQuery.reset();
+                    queriedHierarchy.reset();
+                }
+                statusText = !hierarchyEnabled ? "Hierarchy off"
+                             : built           ? "Hierarchy on"
+                                               : "Hierarchy on, skipped while a weight is negative";
+                statusUntil = GetTime() + 3;
+            } else if (IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_U)) {
+                aStarUnitScale = (aStarUnitScale + 1) % aStarUnitScaleCount;
+                const double scale = aStarUnitScales[aStarUnitScale];
+                statusText = std::isinf(scale) ? "A* guidance off"
+                             : scale < 1
+                                 ? TextFormat("A* unit %gx exact, paths may be longer", scale)
+                                 : TextFormat("A* unit %gx exact", scale);
+                statusUntil = GetTime() + 3;
+            } else if (IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_P)) {
+                if (profiler.capturing()) {
+                    long frames = profiler.stopCapture();
+                    statusText = TextFormat("Wrote %ld frames to %s", frames,
+                                            profileCapturePath.c_str());
+                } else {
+                    statusText = profiler.startCapture(profileCapturePath)
+                                     ? "Capturing frame times to " + profileCapturePath
+                                     : "Could not write " + profileCapturePath;
+                }
+                statusUntil = GetTime() + 3;
+            } else if (IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_O)) {
+                // the selection points into the old graph
+                resetCurrentSelection(currentSelection);
+                weightDraftEdge = -1;
+                statusText = loadGraph(graphPath.string(), store)
+                                 ? "Opened " + graphPath.string()
+                                 : "Could not open " + graphPath.string();
+                vertexLabels.clear();
+                weightLabels.clear();
+                fitCamera();
+                statusUntil = GetTime() + 3;
             }
 
             if (IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
                 for (const auto& menuItem : menuItems) {
-                    if (CheckCollisionPointRec({mouseX, mouseY}, menuItem.rect)) {
+                    if (CheckCollisionPointRec(GetMousePosition(), menuItem.rect)) {
                         currentAction = menuItem.action;
                         auto currentVertex = tryGetVertex(currentSelection);
+                        // labels stay on the ui side, the algorithms work on vertex indices
+                        int startIndex =
+                            currentVertex.has_value()
+                                ? static_cast<int>(currentVertex.value() - vertices.data())
+                                : 0;
                         if (menuItem.isVisible()) {
                             if (!vertices.empty() && !edges.empty()) {
                             }
                             if (currentAction == Action::BFS) {
-                                adjacencyMap = createAdjacencyMap(vertices, edges);
-                                searchTraverseOrder =
-                                    BFS(adjacencyMap, currentVertex.has_value()
-                                                          ? currentVertex.value()->label
-                                                          : "V0");
+                                graph = adjacency(false);
+                                startPlayback(
+                                    Traversal(std::in_place_type<BFSTraversal>, *graph,
+                                              startIndex));
 
                                 currentAlgorithm = Algorithm::BFS;
-                                searching = true;
+                                searching = graph->contains(startIndex);
                                 mouseDown = true;
                             } else if (currentAction == Action::DFS) {
-                                adjacencyMap = createAdjacencyMap(vertices, edges);
-                                searchTraverseOrder =
-                                    DFS(adjacencyMap, currentVertex.has_value()
-                                                          ? currentVertex.value()->label
-                                                          : "V0");
+                                graph = adjacency(false);
+                                startPlayback(
+                                    Traversal(std::in_place_type<DFSTraversal>, *graph,
+                                              startIndex));
 
                                 currentAlgorithm = Algorithm::DFS;
-                                searching = true;
+                                searching = graph->contains(startIndex);
                                 mouseDown = true;
                             } else if (currentAction == Action::Dijkstra) {
                                 if (std::any_of(edges.begin(), edges.end(),
                                                 [](const Edge& edge) { return !edge.weighted; }))
                                     break;
 
-                                auto z = createAdjacencyMapWeighted(vertices, edges);
-                                dijkstraSearchTraverseOrder = Dijkstra(
-                                    z, currentVertex.has_value() ? currentVertex.value()->label
-                                                                 : "V0");
+                                graph = adjacency(true);
+                                startPlayback(
+                                    Traversal(std::in_place_type<DijkstraTraversal>, *graph,
+                                              startIndex));
 
                                 currentAlgorithm = Algorithm::Dijkstra;
-                                searching = true;
+                                searching = graph->contains(startIndex);
                                 mouseDown = true;
+                            } else if (currentAction == Action::AStar) {
+                                // the selected vertex is the start, the next click the target
+                                statusText = currentVertex.has_value()
+                                                 ? "Click the target vertex"
+                                                 : "Select the start vertex first";
+                                statusUntil = GetTime() + 3;
                             }
                         }
                         actionSet = true;
@@ -547,44 +997,35 @@ int main() {
                             break;
                         case Action::Default:
                             if (!mouseDown) {
-                                bool alreadyFoundVertex = false;
-                                for (const auto& vertex : vertices) {
-                                    if (vertex.usable &&
-                                        CheckCollisionPointCircle({mouseX, mouseY}, vertex.pos,
-                                                                  vertex.radius)) {
-                                        currentSelection = const_cast<Vertex*>(&vertex);
-                                        moveStart.x = mouseX;
-                                        moveStart.y = mouseY;
+                                int vertexId = store.spatialIndex().vertexAt({mouseX, mouseY});
+                                if (vertexId != -1) {
+                                    currentSelection = const_cast<Vertex*>(&vertices[vertexId]);
+                                    moveStart.x = mouseX;
+                                    moveStart.y = mouseY;
+                                    mouseDown = true;
+                                } else {
+                                    resetCurrentSelection(currentSelection);
+                                    int edgeId = store.spatialIndex().edgeAt({mouseX, mouseY}, 15);
+                                    if (edgeId != -1) {
+                                        currentSelection = store.findEdge(edgeId);
                                         mouseDown = true;
-                                        alreadyFoundVertex = true;
-                                        break;
-                                    } else {
-                                        resetCurrentSelection(currentSelection);
                                     }
                                 }
-                                if (!alreadyFoundVertex)
-                                    for (const auto& edge : edges) {
-                                        auto vertexFromWithId =
-                                            std::find_if(vertices.begin(), vertices.end(),
-                                                         [&edge](const Vertex& v) {
-                                                             return v.id == edge.fromId;
-                                                         });
-                                        auto vertexToWithId = std::find_if(
-                                            vertices.begin(), vertices.end(),
-                                            [&edge](const Vertex& v) { return v.id == edge.toId; });
-                                        if (CheckCollisionPointLine({mouseX, mouseY},
-                                                                    vertexFromWithId->pos,
-                                                                    vertexToWithId->pos, 15)) {
-                                            currentSelection = const_cast<Edge*>(&edge);
-                                            mouseDown = true;
-                                            break;
-                                        }
-                                    }
                             }
                             break;
                         case Action::Vertex:
                             if (!mouseDown) {
-                                vertices.push_back({{mouseX, mouseY}, vertexRadius, vertexColor});
+                                if (!store.spatialIndex().overlapsVertex({mouseX, mouseY},
+                                                                         vertexRadius)) {
+                                    // adding can move the vertex list, re-resolve the selection
+                                    auto selected = tryGetVertex(currentSelection);
+                                    VertexHandle selectedHandle =
+                                        selected.has_value() ? store.handle(selected.value()->id)
+                                                             : VertexHandle{};
+                                    store.addVertex({mouseX, mouseY}, vertexRadius, vertexColor);
+                                    if (selected.has_value())
+                                        currentSelection = store.resolve(selectedHandle);
+                                }
                                 mouseDown = true;
                             }
                             break;
@@ -595,20 +1036,67 @@ int main() {
                                 edgeStart.x = mouseX;
                                 edgeStart.y = mouseY;
                                 mouseDown = true;
-                            } else
-                                DrawLine(edgeStart.x, edgeStart.y, mouseX, mouseY, BLACK);
+                            }
                             break;
                         case Action::Search:
                             [[fallthrough]];
                         case Action::BFS:
                             [[fallthrough]];
-                        case Action::Dijkstra:
-                            [[fallthrough]];
                         case Action::DFS:
                             if (!mouseDown) {
                                 mouseDown = true;
                             }
                             break;
+                        case Action::Dijkstra:
+                            // clicking a vertex asks for its distance from the selected one, on
+                            // the hierarchy when it is current and with Dijkstra otherwise
+                            if (!mouseDown) {
+                                auto start = tryGetVertex(currentSelection);
+                                int target = store.spatialIndex().vertexAt({mouseX, mouseY});
+                                if (start.has_value() && target != -1 &&
+                                    target != start.value()->id) {
+                                    int from = start.value()->id;
+                                    if (auto answered = queryHierarchy(from, target)) {
+                                        statusText = TextFormat(
+                                            "Distance %d to %d: %g, hierarchy in %.1f us", from,
+                                            target, answered->first, answered->second);
+                                    } else {
+                                        ProfileTimer timer(profiler, SearchPhase);
+                                        const Graph& weighted = *adjacency(true);
+                                        double distance =
+                                            AStar(weighted, std::vector<Vector2>(vertices.size()),
+                                                  from, target, INFINITY)
+                                                .distance;
+                                        statusText = TextFormat("Distance %d to %d: %g, Dijkstra",
+                                                                from, target, distance);
+                                    }
+                                    statusUntil = GetTime() + 3;
+                                }
+                                mouseDown = true;
+                            }
+                            break;
+                        case Action::AStar:
+                            if (!mouseDown) {
+                                auto start = tryGetVertex(currentSelection);
+                                int target = store.spatialIndex().vertexAt({mouseX, mouseY});
+                                if (std::any_of(edges.begin(), edges.end(),
+                                                [](const Edge& edge) { return !edge.weighted; })) {
+                                    statusText = "A* needs every edge to be weighted";
+                                    statusUntil = GetTime() + 3;
+                                } else if (std::any_of(edges.begin(), edges.end(),
+                                                       [](const Edge& edge) {
+                                                           return edge.usable &&
+                                                                  edge.weight.asDouble() < 0;
+                                                       })) {
+                                    statusText = "A* needs weights of 0 or more";
+                                    statusUntil = GetTime() + 3;
+                                } else if (start.has_value() && target != -1 &&
+                                           target != start.value()->id) {
+                                    startAStar(start.value()->id, target);
+                                }
+                                mouseDown = true;
+                            }
+                            break;
                     }
                 }
             }
@@ -625,7 +1113,9 @@ int main() {
                     moveEnd.y = mouseY;
                     if (currentVertexOrNull.has_value() && (moveStart.x != moveEnd.x) &&
                         (moveStart.y != moveEnd.y)) {
-                        currentVertexOrNull.value()->pos = moveEnd;
+                        store.moveVertex(currentVertexOrNull.value()->id, moveEnd);
+                        // the running layout would undo the move with its next snapshot
+                        if (layoutEnabled) layout.start(store, true);
                     }
                     mouseDown = false;
                 } else if (currentAction == Action::Vertex) {
@@ -633,41 +1123,84 @@ int main() {
                 } else if (currentAction == Action::Edge || currentAction == Action::WeightedEdge) {
                     edgeEnd.x = mouseX;
                     edgeEnd.y = mouseY;
-                    int startVertexIndex = -1;
-                    int endVertexIndex = -1;
-                    for (size_t i = 0; i < vertices.size(); ++i) {
-                        if (vertices[i].usable) {
-                            if (CheckCollisionPointCircle(edgeStart, vertices[i].pos,
-                                                          vertices[i].radius))
-                                startVertexIndex = i;
-                            else if (CheckCollisionPointCircle(edgeEnd, vertices[i].pos,
-                                                               vertices[i].radius))
-                                endVertexIndex = i;
-                        }
-                    }
+                    int startVertexIndex = store.spatialIndex().vertexAt(edgeStart);
+                    int endVertexIndex = store.spatialIndex().vertexAt(edgeEnd);
+                    if (endVertexIndex == startVertexIndex) endVertexIndex = -1;
                     if (startVertexIndex != -1 && endVertexIndex != -1) {
-                        bool exists = false;
-                        for (const auto& edge : edges) {
-                            if (edge.fromId == startVertexIndex && edge.toId == endVertexIndex) {
-                                exists = true;
-                                break;
-                            }
-                        }
-                        if (!exists) {
+                        if (store.findEdge(startVertexIndex, endVertexIndex) == nullptr) {
+                            // adding can move the edge list, re-resolve the selection
+                            auto selected = tryGetEdge(currentSelection);
+                            int selectedId = selected.has_value() ? selected.value()->id : -1;
                             if (currentAction == Action::Edge)
-                                edges.push_back({startVertexIndex, endVertexIndex});
+                                store.addEdge({startVertexIndex, endVertexIndex});
                             else
-                                edges.push_back({startVertexIndex, endVertexIndex, "0"});
+                                store.addEdge({startVertexIndex, endVertexIndex, Weight()});
+                            if (selected.has_value()) currentSelection = store.findEdge(selectedId);
                         }
                     }
                     mouseDown = false;
                 } else if (currentAction == Action::Search || currentAction == Action::BFS ||
-                           currentAction == Action::DFS || currentAction == Action::Dijkstra) {
+                           currentAction == Action::DFS || currentAction == Action::Dijkstra ||
+                           currentAction == Action::AStar) {
                     mouseDown = false;
                 }
             }
+            inputTimer.stop();
+
+            // the graph, the menu bar and the edge list only change with the key, the rest is
+            // drawn over them every frame
+            StaticLayerKey key = staticLayerKey(-1);
+            if (staticDirty || key != staticKey) {
+                BeginTextureMode(staticLayer);
+                ClearBackground(WHITE);
+                BeginMode2D(camera);
+                drawGraph(nullptr, edgeLineThickness);
+                EndMode2D();
+                {
+                    ProfileTimer timer(profiler, MenuPhase);
+                    drawMenuBar();
+                }
+                if (detailsOpen) {
+                    // only as many edges as fit on the screen
+                    int i = 0;
+                    for (const auto& edge : edges) {
+                        if (i >= screenHeight) break;
+                        DrawText(edge.weighted ? TextFormat("%d -> %d w: %s", edge.fromId,
+                                                            edge.toId,
+                                                            edge.weight.toString().c_str())
+                                               : TextFormat("%d -> %d", edge.fromId, edge.toId),
+                                 screenWidth / 2.0, i, fontSizeRegular, RED);
+                        i += 15;
+                    }
+                }
+                EndTextureMode();
+                staticKey = key;
+                staticDirty = false;
+            }
+
+            BeginDrawing();
+            drawStaticLayer();
+
+            BeginMode2D(camera);
+            if (auto v = tryGetVertex(currentSelection)) {
+                const Vertex& vertex = *v.value();
+                DrawRectangleLines(vertex.pos.x - 35, vertex.pos.y - 35, 70, 70, GREEN);
+            }
+            if (currentAction == Action::Vertex) {
+                // vertices can't be stacked on top of each other, they would be unpickable
+                DrawCircle(mouseX, mouseY, vertexRadius,
+                           store.spatialIndex().overlapsVertex({mouseX, mouseY}, vertexRadius)
+                               ? vertexBlockedGhostColor
+                               : vertexGhostColor);
+            }
+            if ((currentAction == Action::Edge || currentAction == Action::WeightedEdge) &&
+                mouseDown && !actionSet && IsMouseButtonDown(MOUSE_BUTTON_LEFT))
+                DrawLine(edgeStart.x, edgeStart.y, mouseX, mouseY, BLACK);
+            EndMode2D();
 
             if (detailsOpen) {
+                ProfileTimer timer(profiler, HudPhase);
+                drawProfile();
                 DrawFPS(5, 5);
                 // i love ternaries
                 DrawText(currentAction == Action::Vertex         ? "Mode: Vertex"
@@ -677,13 +1210,14 @@ int main() {
                                                                  : "Mode: Default",
                          5, 25, fontSizeLarge, BLACK);
 
-                int numOfVerticesOnScreen = std::accumulate(
-                    vertices.begin(), vertices.end(), 0,
-                    [](int current, const Vertex& v) { return current + (v.usable ? 1 : 0); });
-
-                DrawText(TextFormat("Vertices: %d", numOfVerticesOnScreen), 5, 45, fontSizeLarge,
+                DrawText(TextFormat("Vertices: %d", store.vertexCount()), 5, 45, fontSizeLarge,
                          BLACK);
                 DrawText(TextFormat("Edges: %d", edges.size()), 5, 65, fontSizeLarge, BLACK);
+                if (layoutEnabled)
+                    DrawText(TextFormat(layout.running() ? "Layout: iteration %d"
+                                                         : "Layout: settled after %d",
+                                        layout.iterations()),
+                             5, 105, fontSizeLarge, BLACK);
 
                 auto v = tryGetVertex(currentSelection);
                 auto e = tryGetEdge(currentSelection);
@@ -696,10 +1230,20 @@ int main() {
                 }
             }
 
-            EndDrawing();
+            if (GetTime() < statusUntil)
+                DrawText(statusText.c_str(), 5, screenHeight - 20, fontSizeRegular, DARKGRAY);
+
+            frameTimer.stop();
+            {
+                ProfileTimer timer(profiler, PresentPhase);
+                EndDrawing();
+            }
         }
+
+        profiler.endFrame();
     }
 
+    UnloadRenderTexture(staticLayer);
     CloseWindow();
 
     return 0;
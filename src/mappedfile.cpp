@@ -0,0 +1,80 @@
+#include "mappedfile.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::optional<MappedFile> MappedFile::open(const std::string& path) {
+    MappedFile file;
+
+#if defined(_WIN32)
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return std::nullopt;
+    file.length = static_cast<std::size_t>(in.tellg());
+    file.owned = new std::byte[std::max<std::size_t>(file.length, 1)];
+    file.bytes = file.owned;
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(file.owned), file.length)) return std::nullopt;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) return std::nullopt;
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    // empty files can't be mapped, they are just an empty view
+    file.length = static_cast<std::size_t>(info.st_size);
+    if (file.length > 0) {
+        void* mapping = ::mmap(nullptr, file.length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            return std::nullopt;
+        }
+        file.bytes = static_cast<const std::byte*>(mapping);
+    }
+    ::close(fd);
+#endif
+
+    return file;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : bytes(std::exchange(other.bytes, nullptr)),
+      length(std::exchange(other.length, 0)),
+      owned(std::exchange(other.owned, nullptr)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        this->release();
+        this->bytes = std::exchange(other.bytes, nullptr);
+        this->length = std::exchange(other.length, 0);
+        this->owned = std::exchange(other.owned, nullptr);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() { this->release(); }
+
+void MappedFile::release() {
+#if defined(_WIN32)
+    delete[] this->owned;
+#else
+    if (this->bytes != nullptr) ::munmap(const_cast<std::byte*>(this->bytes), this->length);
+#endif
+    this->bytes = nullptr;
+    this->owned = nullptr;
+    this->length = 0;
+}
@@ -0,0 +1,38 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Read-only mapping of a whole file, read into memory instead where mmap isn't available. The
+// bytes stay valid for the lifetime of the object.
+class MappedFile {
+   public:
+    // nullopt when the file can't be opened or mapped
+    static std::optional<MappedFile> open(const std::string& path);
+
+    MappedFile(MappedFile&&) noexcept;
+    MappedFile& operator=(MappedFile&&) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    inline const std::byte* data() const { return this->bytes; }
+    inline std::size_t size() const { return this->length; }
+    inline std::string_view text() const {
+        return {reinterpret_cast<const char*>(this->bytes), this->length};
+    }
+
+   private:
+    const std::byte* bytes = nullptr;
+    std::size_t length = 0;
+    // set when the file was read into memory instead of mapped
+    std::byte* owned = nullptr;
+
+    MappedFile() = default;
+    void release();
+};
+
+#endif  // MAPPEDFILE_HPP
@@ -3,7 +3,18 @@
 
 #include <raylib.h>
 
-enum class Action { Details, Default, Vertex, Edge, WeightedEdge, Search, BFS, DFS, Dijkstra };
+enum class Action {
+    Details,
+    Default,
+    Vertex,
+    Edge,
+    WeightedEdge,
+    Search,
+    BFS,
+    DFS,
+    Dijkstra,
+    AStar
+};
 
 struct MenuItem {
     Rectangle rect;
@@ -0,0 +1,29 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// 0 picks the hardware concurrency
+inline int resolveThreadCount(int threadCount) {
+    if (threadCount > 0) return threadCount;
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+// runs work(t) for t in [0, threadCount) on its own thread each and joins them, a single thread
+// runs on the caller
+template <typename Work>
+void runThreads(int threadCount, Work work) {
+    if (threadCount == 1) {
+        work(0);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (int t = 0; t < threadCount; ++t) threads.emplace_back(work, t);
+    for (auto& thread : threads) thread.join();
+}
+
+#endif  // PARALLEL_HPP
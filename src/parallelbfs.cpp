@@ -0,0 +1,239 @@
+#include "parallelbfs.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+
+namespace {
+
+constexpr std::uint64_t unclaimed = std::numeric_limits<std::uint64_t>::max();
+
+// frontier work is handed out in chunks so threads balance skewed degrees themselves
+constexpr size_t frontierChunk = 256;
+constexpr size_t vertexChunk = 4096;
+
+// levels with fewer edges than this are cheaper to expand on the calling thread
+constexpr long parallelThreshold = 1 << 14;
+
+inline bool testBit(const std::vector<std::uint64_t>& bits, int vertex) {
+    return (bits[vertex >> 6] >> (vertex & 63)) & 1;
+}
+
+// true when this call set the bit
+inline bool claimBit(std::vector<std::atomic<std::uint64_t>>& bits, int vertex) {
+    std::uint64_t mask = std::uint64_t{1} << (vertex & 63);
+    return !(bits[vertex >> 6].fetch_or(mask, std::memory_order_relaxed) & mask);
+}
+
+inline void atomicMin(std::atomic<std::uint64_t>& target, std::uint64_t value) {
+    std::uint64_t current = target.load(std::memory_order_relaxed);
+    while (value < current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+// orders discoveries like the serial queue does: by the discoverer's position in the frontier,
+// then by the position of the edge in the discoverer's row
+inline std::uint64_t discoveryKey(int frontierRank, int edge) {
+    return (static_cast<std::uint64_t>(frontierRank) << 32) | static_cast<std::uint32_t>(edge);
+}
+
+using Discovery = std::pair<std::uint64_t, int>;
+
+// Writes the vertices of the sorted runs to out in key order. The key range is cut into parts
+// at keys sampled from the longest run; every thread merges its part of each run into place, the
+// parts before it tell it where that is. Keys are unique, so no vertex lands in two parts.
+void mergeRuns(std::vector<std::vector<Discovery>>& runs, int parts, int* out) {
+    const auto longest = std::max_element(runs.begin(), runs.end(), [](auto& lhs, auto& rhs) {
+        return lhs.size() < rhs.size();
+    });
+    std::vector<std::uint64_t> splits;
+    for (int p = 1; p < parts; ++p)
+        splits.push_back((*longest)[longest->size() * p / parts].first);
+
+    // first index of part p in a run, parts past the last split end at the run's end
+    auto partStart = [&](const std::vector<Discovery>& run, int p) {
+        if (p == 0) return size_t(0);
+        if (p == parts) return run.size();
+        auto split = std::lower_bound(run.begin(), run.end(), Discovery{splits[p - 1], -1});
+        return static_cast<size_t>(split - run.begin());
+    };
+
+    runThreads(parts, [&](int p) {
+        size_t offset = 0;
+        for (const auto& run : runs) offset += partStart(run, p);
+
+        std::vector<Discovery> merged;
+        for (const auto& run : runs) {
+            const size_t middle = merged.size();
+            merged.insert(merged.end(), run.begin() + partStart(run, p),
+                          run.begin() + partStart(run, p + 1));
+            std::inplace_merge(merged.begin(), merged.begin() + middle, merged.end());
+        }
+        for (const auto& [key, v] : merged) out[offset++] = v;
+    });
+}
+
+}  // namespace
+
+ReverseGraph createReverseGraph(const Graph& graph) {
+    ReverseGraph reverse;
+    const int vertexCount = graph.vertexCount();
+
+    reverse.offsets.assign(vertexCount + 1, 0);
+    for (int target : graph.targets) ++reverse.offsets[target + 1];
+    for (int v = 0; v < vertexCount; ++v) reverse.offsets[v + 1] += reverse.offsets[v];
+
+    reverse.sources.resize(graph.edgeCount());
+    reverse.sourceEdges.resize(graph.edgeCount());
+
+    std::vector<int> cursor(reverse.offsets.begin(), reverse.offsets.end() - 1);
+    for (int u = 0; u < vertexCount; ++u) {
+        for (int e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+            int slot = cursor[graph.targets[e]]++;
+            reverse.sources[slot] = u;
+            reverse.sourceEdges[slot] = e;
+        }
+    }
+
+    return reverse;
+}
+
+BFSResult ParallelBFS(const Graph& graph, int startVertex, int threadCount,
+                      const ReverseGraph* reverse) {
+    BFSResult result;
+    if (!graph.contains(startVertex)) return result;
+
+    const int vertexCount = graph.vertexCount();
+    threadCount = resolveThreadCount(threadCount);
+
+    std::optional<ReverseGraph> ownedReverse;
+
+    // claims for top-down steps; a vertex visited before the current level already has its
+    // level, so nothing has to be copied to tell the two apart
+    const size_t words = (static_cast<size_t>(vertexCount) + 63) / 64;
+    std::vector<std::atomic<std::uint64_t>> visited(words);
+    std::vector<std::atomic<std::uint64_t>> keys(vertexCount);
+    for (auto& key : keys) key.store(unclaimed, std::memory_order_relaxed);
+
+    // rank is the position in the current frontier, only meaningful for frontier vertices
+    std::vector<int> rank(vertexCount, -1);
+    result.level.assign(vertexCount, -1);
+
+    auto degree = [&graph](int v) {
+        return static_cast<long>(graph.offsets[v + 1] - graph.offsets[v]);
+    };
+
+    // every level is written straight after the previous one, the frontier is the last level
+    // written; the order is cut to the reached vertices at the end
+    result.order.resize(vertexCount);
+    result.order[0] = startVertex;
+    result.level[startVertex] = 0;
+    rank[startVertex] = 0;
+    claimBit(visited, startVertex);
+    size_t levelBegin = 0, levelEnd = 1;
+
+    long frontierEdges = degree(startVertex);
+    long unexploredEdges = graph.edgeCount() - frontierEdges;
+
+    std::vector<std::vector<Discovery>> discovered(threadCount);
+    std::vector<long> partEdges(threadCount);
+
+    for (int depth = 0; levelBegin < levelEnd; ++depth) {
+        // bottom-up looks at the in-edges of every unvisited vertex, which pays off once the
+        // frontier has more edges than the rest of the graph
+        const bool bottomUp = frontierEdges > unexploredEdges;
+        if (bottomUp && reverse == nullptr) {
+            ownedReverse = createReverseGraph(graph);
+            reverse = &*ownedReverse;
+        }
+
+        const int* frontier = result.order.data() + levelBegin;
+        const size_t frontierSize = levelEnd - levelBegin;
+        const int threads =
+            std::max(frontierEdges, bottomUp ? unexploredEdges : 0L) < parallelThreshold
+                ? 1
+                : threadCount;
+        std::atomic<size_t> cursor{0};
+
+        runThreads(threads, [&](int thread) {
+            auto& local = discovered[thread];
+
+            if (bottomUp) {
+                // every frontier parent is looked at, the earliest one decides the key as it
+                // does top-down; only this thread touches v, no claim needed
+                for (size_t first; (first = cursor.fetch_add(vertexChunk)) < size_t(vertexCount);) {
+                    int last = static_cast<int>(std::min(first + vertexChunk, size_t(vertexCount)));
+                    for (int v = static_cast<int>(first); v < last; ++v) {
+                        if (result.level[v] != -1) continue;
+
+                        std::uint64_t key = unclaimed;
+                        for (int i = reverse->offsets[v]; i < reverse->offsets[v + 1]; ++i) {
+                            int u = reverse->sources[i];
+                            if (result.level[u] == depth)
+                                key = std::min(key, discoveryKey(rank[u], reverse->sourceEdges[i]));
+                        }
+                        if (key == unclaimed) continue;
+                        keys[v].store(key, std::memory_order_relaxed);
+                        local.push_back({0, v});
+                    }
+                }
+            } else {
+                for (size_t first; (first = cursor.fetch_add(frontierChunk)) < frontierSize;) {
+                    size_t last = std::min(first + frontierChunk, frontierSize);
+                    for (size_t i = first; i < last; ++i) {
+                        int u = frontier[i];
+                        for (int e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                            int v = graph.targets[e];
+                            if (result.level[v] != -1) continue;
+
+                            atomicMin(keys[v], discoveryKey(static_cast<int>(i), e));
+                            if (claimBit(visited, v)) local.push_back({0, v});
+                        }
+                    }
+                }
+            }
+        });
+
+        // the keys are final once every thread is done, each sorts what it found and the runs
+        // are merged behind the frontier
+        size_t found = 0;
+        runThreads(threads, [&](int thread) {
+            for (int t = thread; t < threadCount; t += threads) {
+                for (auto& [key, v] : discovered[t]) key = keys[v].load(std::memory_order_relaxed);
+                std::sort(discovered[t].begin(), discovered[t].end());
+            }
+        });
+        for (const auto& local : discovered) found += local.size();
+        if (found > 0) mergeRuns(discovered, threads, result.order.data() + levelEnd);
+        for (auto& local : discovered) local.clear();
+
+        levelBegin = levelEnd;
+        levelEnd += found;
+        const size_t chunk = (found + threads - 1) / threads;
+        runThreads(threads, [&](int thread) {
+            long edges = 0;
+            const size_t first = levelBegin + std::min(found, chunk * thread);
+            const size_t last = levelBegin + std::min(found, chunk * (thread + 1));
+            for (size_t position = first; position < last; ++position) {
+                int v = result.order[position];
+                result.level[v] = depth + 1;
+                rank[v] = static_cast<int>(position - levelBegin);
+                edges += degree(v);
+            }
+            partEdges[thread] = edges;
+        });
+        frontierEdges = 0;
+        for (int thread = 0; thread < threads; ++thread) frontierEdges += partEdges[thread];
+        unexploredEdges -= frontierEdges;
+    }
+
+    result.order.resize(levelEnd);
+    return result;
+}
@@ -0,0 +1,36 @@
+#ifndef PARALLELBFS_HPP
+#define PARALLELBFS_HPP
+
+#include <vector>
+
+#include "graph.hpp"
+
+// In-edges of every vertex for bottom-up steps, sources of v are sources[offsets[v]] ..
+// sources[offsets[v + 1] - 1] and sourceEdges holds the index of each edge in graph.targets.
+struct ReverseGraph {
+    std::vector<int> offsets;
+    std::vector<int> sources;
+    std::vector<int> sourceEdges;
+};
+
+struct BFSResult {
+    // the vertices in the order BFS(graph, startVertex) visits them
+    std::vector<int> order;
+    // hops from the start vertex, -1 when unreachable
+    std::vector<int> level;
+};
+
+ReverseGraph createReverseGraph(const Graph&);
+
+// Level-synchronous BFS over threadCount threads (0 picks the hardware concurrency). Each level
+// is expanded top-down from the frontier or bottom-up from the unvisited vertices, whichever has
+// fewer edges to look at. Within a level vertices are ordered by the (frontier position, edge)
+// pair of their earliest discovery, found with an atomic min top-down and by looking at every
+// frontier parent bottom-up, so the order is exactly the one BFS(graph, startVertex) visits in,
+// whatever the thread count. Each thread sorts what it discovered and the sorted runs are merged
+// in parallel. Pass a prebuilt reverse graph to reuse it across calls, otherwise it is built on
+// the first bottom-up step.
+BFSResult ParallelBFS(const Graph&, int startVertex, int threadCount = 0,
+                      const ReverseGraph* reverse = nullptr);
+
+#endif  // PARALLELBFS_HPP
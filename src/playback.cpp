@@ -0,0 +1,116 @@
+#include "playback.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// unlimited speed stops stepping after this much of a frame so the window stays responsive
+constexpr std::chrono::microseconds unlimitedFrameBudget{8000};
+// steps taken between clock reads at unlimited speed
+constexpr int unlimitedBatch = 256;
+
+}  // namespace
+
+Playback::Playback(const Graph& graph, Traversal traversal) : traversal(std::move(traversal)) {
+    this->graph = &graph;
+    this->vertexMarks.assign(graph.vertexCount(), VertexMark::None);
+}
+
+void Playback::update(double frameTime) {
+    if (this->paused || this->atEnd()) return;
+
+    if (this->stepsPerSecond <= unlimitedSpeed) {
+        using Clock = std::chrono::steady_clock;
+        auto deadline = Clock::now() + unlimitedFrameBudget;
+        do {
+            for (int i = 0; i < unlimitedBatch; ++i)
+                if (!this->stepForward()) return;
+        } while (Clock::now() < deadline);
+        return;
+    }
+
+    this->pending += frameTime * this->stepsPerSecond;
+    while (this->pending >= 1) {
+        if (!this->stepForward()) {
+            this->pending = 0;
+            return;
+        }
+        this->pending -= 1;
+    }
+}
+
+bool Playback::stepForward() {
+    if (this->step == static_cast<int>(this->visits.size()) && !this->pull()) return false;
+
+    this->stepChanges.push_back(static_cast<int>(this->changes.size()));
+    this->apply(this->visits[this->step]);
+    ++this->step;
+    return true;
+}
+
+void Playback::stepBack() { this->seek(this->step - 1); }
+
+void Playback::seek(int target) {
+    target = std::max(target, 0);
+
+    while (this->step > target) this->undo();
+    while (this->step < target && this->stepForward()) {
+    }
+    this->pending = 0;
+}
+
+int Playback::totalSteps() {
+    while (this->pull()) {
+    }
+    return static_cast<int>(this->visits.size());
+}
+
+bool Playback::pull() {
+    if (this->exhausted) return false;
+
+    // relax steps add nothing on screen, a visit already marks every out-neighbour
+    std::optional<TraversalStep> next;
+    while ((next = nextStep(this->traversal)) && next->kind != TraversalStep::Kind::Visit) {
+    }
+
+    if (!next.has_value()) {
+        this->exhausted = true;
+        return false;
+    }
+
+    this->visits.push_back(*next);
+    return true;
+}
+
+void Playback::apply(const TraversalStep& visit) {
+    this->setMark(visit.vertex, VertexMark::Visited);
+
+    for (int i = this->graph->offsets[visit.vertex]; i < this->graph->offsets[visit.vertex + 1];
+         ++i) {
+        int target = this->graph->targets[i];
+        if (this->vertexMarks[target] == VertexMark::None)
+            this->setMark(target, VertexMark::Frontier);
+    }
+}
+
+void Playback::setMark(int vertex, VertexMark mark) {
+    if (this->vertexMarks[vertex] == mark) return;
+    this->changes.push_back({vertex, this->vertexMarks[vertex]});
+    this->vertexMarks[vertex] = mark;
+}
+
+void Playback::undo() {
+    int begin = this->stepChanges.back();
+    this->stepChanges.pop_back();
+    // newest first, a vertex changed twice in one step ends at its oldest mark
+    while (static_cast<int>(this->changes.size()) > begin) {
+        auto [vertex, mark] = this->changes.back();
+        this->changes.pop_back();
+        this->vertexMarks[vertex] = mark;
+    }
+    --this->step;
+}
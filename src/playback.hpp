@@ -0,0 +1,91 @@
+#ifndef PLAYBACK_HPP
+#define PLAYBACK_HPP
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "graph.hpp"
+#include "traversal.hpp"
+
+// what a search visualisation shows for one vertex
+enum class VertexMark : std::uint8_t { None, Frontier, Visited };
+
+// Frame-driven player for a traversal. Visits are pulled from the traversal only when playback
+// first reaches them and are logged, so the player can step back and seek to any step without
+// rerunning the search. Step k is the state after the first k visits: visited vertices, the
+// out-neighbours of visited vertices as frontier, and the k-th visit as current. Marks only ever
+// go from None to Frontier to Visited, so every mark a step changes is logged with the value it
+// had before: stepping back undoes exactly the marks of the last step, and seeking backwards
+// costs the marks changed since the target. The log holds at most two entries per vertex.
+class Playback {
+   public:
+    // steps per second meaning "as many as fit in the frame budget"
+    static constexpr double unlimitedSpeed = 0;
+
+    Playback(const Graph&, Traversal traversal);
+
+    // advances by frameTime seconds of playback at the current speed, no-op while paused
+    void update(double frameTime);
+
+    // false once the traversal is exhausted
+    bool stepForward();
+    void stepBack();
+    // clamps to [0, total steps]; seeking past the visits seen so far runs the traversal on
+    void seek(int step);
+
+    inline void setSpeed(double stepsPerSecond) {
+        this->stepsPerSecond = stepsPerSecond;
+        this->pending = 0;
+    }
+    inline double speed() const { return this->stepsPerSecond; }
+    inline void setPaused(bool paused) {
+        this->paused = paused;
+        this->pending = 0;
+    }
+    inline bool isPaused() const { return this->paused; }
+
+    inline int position() const { return this->step; }
+    // visits pulled from the traversal so far, the total once totalKnown()
+    inline int knownSteps() const { return static_cast<int>(this->visits.size()); }
+    inline bool totalKnown() const { return this->exhausted; }
+    inline bool atEnd() const {
+        return this->exhausted && this->step == static_cast<int>(this->visits.size());
+    }
+    // runs the traversal to the end the first time it is called
+    int totalSteps();
+
+    inline const std::vector<VertexMark>& marks() const { return this->vertexMarks; }
+    // the latest visit, nullopt at step 0
+    inline std::optional<TraversalStep> currentStep() const {
+        if (this->step == 0) return std::nullopt;
+        return this->visits[this->step - 1];
+    }
+
+   private:
+    const Graph* graph;
+    Traversal traversal;
+    bool exhausted = false;
+    std::vector<TraversalStep> visits;
+
+    int step = 0;
+    std::vector<VertexMark> vertexMarks;
+    // (vertex, mark before) for every mark changed by steps 0 .. step - 1, and where in it each
+    // of those steps starts
+    std::vector<std::pair<int, VertexMark>> changes;
+    std::vector<int> stepChanges;
+
+    double stepsPerSecond = 1;
+    bool paused = false;
+    // fractional steps carried over between frames
+    double pending = 0;
+
+    bool pull();
+    void apply(const TraversalStep& visit);
+    void setMark(int vertex, VertexMark mark);
+    // reverts the last step's marks
+    void undo();
+};
+
+#endif  // PLAYBACK_HPP
@@ -0,0 +1,67 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+FrameProfiler::FrameProfiler(std::vector<std::string> phaseNames, int windowSize)
+    : names(std::move(phaseNames)),
+      current(this->names.size(), Clock::duration::zero()),
+      window(this->names.size() * windowSize),
+      windowSize(windowSize) {}
+
+FrameProfiler::~FrameProfiler() { this->stopCapture(); }
+
+void FrameProfiler::endFrame() {
+    if (this->capture != nullptr) std::fprintf(this->capture, "%ld", this->frame);
+
+    for (int phase = 0; phase < this->phaseCount(); ++phase) {
+        double milliseconds =
+            std::chrono::duration<double, std::milli>(this->current[phase]).count();
+        this->window[static_cast<size_t>(phase) * this->windowSize + this->next] = milliseconds;
+        if (this->capture != nullptr) std::fprintf(this->capture, ",%.4f", milliseconds);
+        this->current[phase] = Clock::duration::zero();
+    }
+
+    if (this->capture != nullptr) {
+        std::fputc('\n', this->capture);
+        ++this->capturedFrames;
+    }
+    this->next = (this->next + 1) % this->windowSize;
+    this->filled = std::min(this->filled + 1, this->windowSize);
+    ++this->frame;
+}
+
+double FrameProfiler::percentile(int phase, double fraction) const {
+    if (this->filled == 0) return 0;
+
+    auto first = this->window.begin() + static_cast<size_t>(phase) * this->windowSize;
+    std::vector<double> samples(first, first + this->filled);
+    // nearest rank
+    auto rank = samples.begin() + std::min<size_t>(static_cast<size_t>(fraction * samples.size()),
+                                                   samples.size() - 1);
+    std::nth_element(samples.begin(), rank, samples.end());
+    return *rank;
+}
+
+bool FrameProfiler::startCapture(const std::string& path) {
+    this->stopCapture();
+
+    this->capture = std::fopen(path.c_str(), "w");
+    if (this->capture == nullptr) return false;
+
+    std::fputs("frame", this->capture);
+    for (const std::string& name : this->names) std::fprintf(this->capture, ",%s_ms", name.c_str());
+    std::fputc('\n', this->capture);
+    this->capturedFrames = 0;
+    return true;
+}
+
+long FrameProfiler::stopCapture() {
+    if (this->capture == nullptr) return 0;
+
+    std::fclose(this->capture);
+    this->capture = nullptr;
+    return this->capturedFrames;
+}
@@ -0,0 +1,74 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Per-frame time spent in named phases. Timers add to the current frame's sample of their phase,
+// so a phase may be timed in several places or not at all in a frame; endFrame() stores the
+// sample in a rolling window of the last windowSize frames, which the percentiles are taken
+// over, and appends it to the CSV file while a capture runs.
+class FrameProfiler {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FrameProfiler(std::vector<std::string> phaseNames, int windowSize = 240);
+    ~FrameProfiler();
+
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    inline void add(int phase, Clock::duration elapsed) { this->current[phase] += elapsed; }
+    void endFrame();
+
+    inline int phaseCount() const { return static_cast<int>(this->names.size()); }
+    inline const std::string& phaseName(int phase) const { return this->names[phase]; }
+    // milliseconds, over the frames in the window (0 before the first frame ends)
+    double percentile(int phase, double fraction) const;
+
+    // Writes a header and then one row per frame, frame number followed by each phase in
+    // milliseconds. false when the file can't be created. Starting again ends the last capture.
+    bool startCapture(const std::string& path);
+    // returns the number of frames written
+    long stopCapture();
+    inline bool capturing() const { return this->capture != nullptr; }
+
+   private:
+    std::vector<std::string> names;
+    std::vector<Clock::duration> current;
+    // windowSize samples per phase, phase-major, filled round robin
+    std::vector<double> window;
+    int windowSize;
+    int filled = 0;
+    int next = 0;
+    long frame = 0;
+
+    std::FILE* capture = nullptr;
+    long capturedFrames = 0;
+};
+
+// Times from construction to stop() or destruction into one phase of the current frame.
+class ProfileTimer {
+   public:
+    ProfileTimer(FrameProfiler& profiler, int phase)
+        : profiler(&profiler), phase(phase), start(FrameProfiler::Clock::now()) {}
+    ~ProfileTimer() { this->stop(); }
+
+    ProfileTimer(const ProfileTimer&) = delete;
+    ProfileTimer& operator=(const ProfileTimer&) = delete;
+
+    inline void stop() {
+        if (this->profiler == nullptr) return;
+        this->profiler->add(this->phase, FrameProfiler::Clock::now() - this->start);
+        this->profiler = nullptr;
+    }
+
+   private:
+    FrameProfiler* profiler;
+    int phase;
+    FrameProfiler::Clock::time_point start;
+};
+
+#endif  // PROFILER_HPP
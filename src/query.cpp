@@ -0,0 +1,473 @@
+// Answers BFS, DFS, Dijkstra and A* queries on a graph file without a window, for scripts and
+// pipelines. The graph is loaded once and every query of the batch runs against it.
+//
+//   graphiz_query GRAPH [--format json|binary] [--threads T] [--distance-unit U] [--hierarchy]
+//                 [--query "ALGORITHM SOURCE [TARGET]"]...
+//   graphiz_query GRAPH --all-pairs FILE [--threads T]
+//
+// GRAPH is a .gphz file or anything the importer reads. Without --query the queries are read
+// from stdin, one "ALGORITHM SOURCE [TARGET]" per line with ALGORITHM bfs, dfs, dijkstra or
+// astar; empty lines and lines starting with # are skipped. Dijkstra and A* treat unweighted
+// edges as 0. A* needs a target and is guided by the vertex positions, with U as the
+// straight-line distance per unit of weight; by default the smallest unit that keeps it exact.
+// --hierarchy builds a contraction hierarchy once after loading and answers Dijkstra queries
+// with a target on it, which pays off for batches of many point-to-point queries. It refuses
+// graphs with negative weights, whose shortest paths a hierarchy can't represent. BFS queries
+// without a target run level by level on the threads the rest of the batch leaves idle, in the
+// same visit order as the serial BFS.
+//
+// Without a target a query reports every vertex reached from the source in visit order with
+// its distance (BFS level, DFS tree depth, Dijkstra distance). With one it stops at the target
+// and reports whether it was reached, the distance and, for Dijkstra and A*, the shortest path.
+//
+// json writes one object per query and line, in input order:
+//   {"algorithm":"bfs","source":0,"visited":[0,4,2],"distance":[0,1,1]}
+//   {"algorithm":"dijkstra","source":0,"target":2,"reached":true,"distance":7,"path":[0,4,2]}
+// binary writes one record per query in host byte order:
+//   uint8 algorithm (0 bfs, 1 dfs, 2 dijkstra, 3 astar), uint8 reached, uint16 0, int32 source,
+//   int32 target (-1 without), float64 distance (0 without target or when unreached),
+//   uint32 count, count int32 vertices, count float64 distances
+// where the vertices are the visit order without a target and the shortest path with one.
+//
+// --all-pairs writes the shortest distance between every pair of vertices to FILE as a distance
+// matrix file (see allpairs.hpp) instead of answering queries, Dijkstra weights apply. Graphs
+// with more than maxAllPairsVertices vertices are refused.
+//
+// Malformed queries are reported on stderr and skipped, the exit status is 1 if there were any.
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "allpairs.hpp"
+#include "contraction.hpp"
+#include "graph.hpp"
+#include "graphfile.hpp"
+#include "graphstore.hpp"
+#include "importer.hpp"
+#include "parallel.hpp"
+#include "parallelbfs.hpp"
+#include "traversal.hpp"
+#include "util.hpp"
+
+namespace {
+
+// queries answered between two writes, bounds the buffered output
+constexpr size_t batchSize = 1024;
+
+struct Options {
+    std::string graphPath;
+    bool binary = false;
+    int threads = 0;
+    // 0 picks minimumDistanceUnit
+    double distanceUnit = 0;
+    bool hierarchy = false;
+    // distance matrix output, no queries are answered when set
+    std::string allPairsPath;
+    std::vector<std::string> queries;
+};
+
+struct QueryGraph {
+    Graph graph;
+    // one per vertex, for A*
+    std::vector<Vector2> positions;
+    double distanceUnit = 1;
+    // with --hierarchy, for Dijkstra queries with a target
+    std::optional<ContractionHierarchy> hierarchy;
+    // for BFS queries without a target, built for the first batch that has one
+    std::optional<ReverseGraph> reverse;
+};
+
+struct Query {
+    Algorithm algorithm;
+    int source;
+    int target = -1;
+};
+
+struct Result {
+    bool reached = false;
+    double distance = 0;
+    // visit order without a target, the shortest path with one
+    std::vector<int> vertices;
+    std::vector<double> distances;
+};
+
+constexpr const char* algorithmNames[] = {"bfs", "dfs", "dijkstra", "astar"};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        auto next = [&](const char* name) -> const char* {
+            if (std::strcmp(argv[i], name) != 0 || i + 1 >= argc) return nullptr;
+            return argv[++i];
+        };
+
+        if (const char* value = next("--format")) {
+            if (std::strcmp(value, "binary") != 0 && std::strcmp(value, "json") != 0)
+                return false;
+            options.binary = std::strcmp(value, "binary") == 0;
+        } else if (const char* value = next("--threads")) {
+            options.threads = std::atoi(value);
+        } else if (const char* value = next("--distance-unit")) {
+            options.distanceUnit = std::atof(value);
+        } else if (std::strcmp(argv[i], "--hierarchy") == 0) {
+            options.hierarchy = true;
+        } else if (const char* value = next("--all-pairs")) {
+            options.allPairsPath = value;
+        } else if (const char* value = next("--query")) {
+            options.queries.emplace_back(value);
+        } else if (argv[i][0] != '-' && options.graphPath.empty()) {
+            options.graphPath = argv[i];
+        } else {
+            return false;
+        }
+    }
+
+    return !options.graphPath.empty() && options.threads >= 0 && options.distanceUnit >= 0;
+}
+
+std::optional<QueryGraph> loadQueryGraph(const Options& options) {
+    const std::string& path = options.graphPath;
+    QueryGraph loaded;
+
+    if (std::filesystem::path(path).extension() == ".gphz") {
+        auto file = MappedGraphFile::open(path);
+        if (!file.has_value()) {
+            std::fprintf(stderr, "%s: not a readable .gphz file\n", path.c_str());
+            return std::nullopt;
+        }
+        auto graph = file->graph(true);
+        if (!graph.has_value()) {
+            std::fprintf(stderr, "%s: corrupt adjacency\n", path.c_str());
+            return std::nullopt;
+        }
+        loaded.graph = std::move(*graph);
+        loaded.positions.assign(file->positions().begin(), file->positions().end());
+    } else {
+        GraphStore store;
+        std::string error;
+        if (!importGraph(path, importFormatFor(path), store, {}, &error)) {
+            std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+            return std::nullopt;
+        }
+        loaded.graph = store.weightedGraph();
+        for (const Vertex& vertex : store.vertices()) loaded.positions.push_back(vertex.pos);
+    }
+
+    loaded.distanceUnit = options.distanceUnit > 0
+                              ? options.distanceUnit
+                              : minimumDistanceUnit(loaded.graph, loaded.positions);
+    if (options.hierarchy) {
+        loaded.hierarchy = ContractionHierarchy::build(loaded.graph);
+        if (!loaded.hierarchy.has_value()) {
+            std::fprintf(stderr, "%s: --hierarchy needs weights of 0 or more\n", path.c_str());
+            return std::nullopt;
+        }
+    }
+    return loaded;
+}
+
+// nullopt for empty lines and comments, error is set when the line is malformed
+std::optional<Query> parseQuery(std::string_view line, const Graph& graph, std::string& error) {
+    std::vector<std::string_view> tokens;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        size_t begin = line.find_first_not_of(" \t\r", pos);
+        if (begin == std::string_view::npos) break;
+        size_t end = line.find_first_of(" \t\r", begin);
+        if (end == std::string_view::npos) end = line.size();
+        tokens.push_back(line.substr(begin, end - begin));
+        pos = end;
+    }
+    if (tokens.empty() || tokens[0][0] == '#') return std::nullopt;
+
+    if (tokens.size() < 2 || tokens.size() > 3) {
+        error = "expected ALGORITHM SOURCE [TARGET]";
+        return std::nullopt;
+    }
+
+    Query query{};
+    if (tokens[0] == "bfs")
+        query.algorithm = Algorithm::BFS;
+    else if (tokens[0] == "dfs")
+        query.algorithm = Algorithm::DFS;
+    else if (tokens[0] == "dijkstra")
+        query.algorithm = Algorithm::Dijkstra;
+    else if (tokens[0] == "astar")
+        query.algorithm = Algorithm::AStar;
+    else {
+        error = "unknown algorithm " + std::string(tokens[0]);
+        return std::nullopt;
+    }
+
+    auto vertex = [&](std::string_view token, int& out) {
+        auto [end, status] = std::from_chars(token.data(), token.data() + token.size(), out);
+        if (status != std::errc() || end != token.data() + token.size() || !graph.contains(out)) {
+            error = "no vertex " + std::string(token);
+            return false;
+        }
+        return true;
+    };
+    if (!vertex(tokens[1], query.source)) return std::nullopt;
+    if (tokens.size() == 3 && !vertex(tokens[2], query.target)) return std::nullopt;
+    if (query.algorithm == Algorithm::AStar && query.target == -1) {
+        error = "astar needs a target";
+        return std::nullopt;
+    }
+    return query;
+}
+
+// one per thread, sized to the graph once. Only entries the current query relaxed are read, so
+// nothing is cleared between queries
+struct Scratch {
+    std::vector<int> parent;
+    std::vector<double> distance;
+    std::optional<HierarchyQuery> hierarchy;
+};
+
+void answer(const QueryGraph& loaded, const Query& query, int threadCount, Scratch& scratch,
+            Result& result) {
+    const Graph& graph = loaded.graph;
+    // cleared rather than reassigned, the buffers are reused from query to query
+    result.reached = false;
+    result.distance = 0;
+    result.vertices.clear();
+    result.distances.clear();
+
+    if (query.algorithm == Algorithm::Dijkstra && query.target != -1 && scratch.hierarchy) {
+        HierarchyPath found = scratch.hierarchy->shortestPath(query.source, query.target);
+        if (found.path.empty()) return;
+        result.reached = true;
+        result.distance = found.distance;
+        result.vertices = std::move(found.path);
+        // the distances along the path, summed over the cheapest edge between each pair
+        result.distances.push_back(0);
+        for (size_t i = 1; i < result.vertices.size(); ++i) {
+            int from = result.vertices[i - 1];
+            double weight = std::numeric_limits<double>::infinity();
+            for (int e = graph.offsets[from]; e < graph.offsets[from + 1]; ++e)
+                if (graph.targets[e] == result.vertices[i])
+                    weight = std::min(weight, graph.isWeighted() ? graph.weights[e] : 1);
+            result.distances.push_back(result.distances.back() + weight);
+        }
+        return;
+    }
+
+    if (query.algorithm == Algorithm::BFS && query.target == -1) {
+        BFSResult found = ParallelBFS(graph, query.source, threadCount, &*loaded.reverse);
+        result.reached = true;
+        result.vertices = std::move(found.order);
+        for (int vertex : result.vertices) result.distances.push_back(found.level[vertex]);
+        return;
+    }
+
+    Traversal traversal =
+        query.algorithm == Algorithm::BFS
+            ? Traversal(std::in_place_type<BFSTraversal>, graph, query.source)
+        : query.algorithm == Algorithm::DFS
+            ? Traversal(std::in_place_type<DFSTraversal>, graph, query.source)
+        : query.algorithm == Algorithm::Dijkstra
+            ? Traversal(std::in_place_type<DijkstraTraversal>, graph, query.source)
+            : Traversal(std::in_place_type<AStarTraversal>, graph, loaded.positions, query.source,
+                        query.target, loaded.distanceUnit);
+
+    // a relax lowers the distance through the vertex visited last
+    int lastVisit = -1;
+    while (auto step = nextStep(traversal)) {
+        if (step->kind == TraversalStep::Kind::Relax) {
+            scratch.parent[step->vertex] = lastVisit;
+            scratch.distance[step->vertex] = step->distance;
+            continue;
+        }
+        lastVisit = step->vertex;
+
+        if (query.target == -1) {
+            result.vertices.push_back(step->vertex);
+            result.distances.push_back(step->distance);
+        } else if (step->vertex == query.target) {
+            result.reached = true;
+            result.distance = step->distance;
+            break;
+        }
+    }
+
+    if (query.target == -1) {
+        result.reached = true;
+    } else if (result.reached &&
+               (query.algorithm == Algorithm::Dijkstra || query.algorithm == Algorithm::AStar)) {
+        for (int v = query.target; v != query.source; v = scratch.parent[v]) {
+            result.vertices.push_back(v);
+            result.distances.push_back(scratch.distance[v]);
+        }
+        result.vertices.push_back(query.source);
+        result.distances.push_back(0);
+        std::reverse(result.vertices.begin(), result.vertices.end());
+        std::reverse(result.distances.begin(), result.distances.end());
+    }
+}
+
+void appendNumber(std::string& out, double number, bool integral) {
+    char buffer[32];
+    auto [end, status] = integral ? std::to_chars(buffer, buffer + sizeof(buffer),
+                                                  static_cast<long long>(number))
+                                  : std::to_chars(buffer, buffer + sizeof(buffer), number);
+    out.append(buffer, end);
+}
+
+void writeJson(const Query& query, const Result& result, std::string& out) {
+    // BFS levels and DFS depths are whole numbers
+    const bool integral =
+        query.algorithm == Algorithm::BFS || query.algorithm == Algorithm::DFS;
+    auto appendList = [&](const char* name, const auto& values, bool integralValues) {
+        out += ",\"";
+        out += name;
+        out += "\":[";
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i > 0) out += ',';
+            appendNumber(out, values[i], integralValues);
+        }
+        out += ']';
+    };
+
+    out += "{\"algorithm\":\"";
+    out += algorithmNames[static_cast<int>(query.algorithm)];
+    out += "\",\"source\":";
+    appendNumber(out, query.source, true);
+    if (query.target == -1) {
+        appendList("visited", result.vertices, true);
+        appendList("distance", result.distances, integral);
+    } else {
+        out += ",\"target\":";
+        appendNumber(out, query.target, true);
+        out += result.reached ? ",\"reached\":true,\"distance\":" : ",\"reached\":false";
+        if (result.reached) appendNumber(out, result.distance, integral);
+        if (!integral && result.reached) appendList("path", result.vertices, true);
+    }
+    out += "}\n";
+}
+
+void writeBinary(const Query& query, const Result& result, std::string& out) {
+    auto append = [&](auto value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    append(static_cast<std::uint8_t>(query.algorithm));
+    append(static_cast<std::uint8_t>(result.reached));
+    append(std::uint16_t{0});
+    append(static_cast<std::int32_t>(query.source));
+    append(static_cast<std::int32_t>(query.target));
+    append(result.distance);
+    append(static_cast<std::uint32_t>(result.vertices.size()));
+    for (int vertex : result.vertices) append(static_cast<std::int32_t>(vertex));
+    for (double distance : result.distances) append(distance);
+}
+
+// answers the batch on up to threadCount threads and writes the results in order
+void runBatch(QueryGraph& loaded, const std::vector<Query>& batch, const Options& options,
+              std::vector<Scratch>& scratch, std::vector<std::string>& outputs) {
+    const int threadCount =
+        std::min(static_cast<int>(batch.size()), static_cast<int>(scratch.size()));
+    // a batch smaller than the thread count hands the rest to the queries that can use them
+    const int queryThreadCount = std::max(1, static_cast<int>(scratch.size()) / threadCount);
+    outputs.resize(batch.size());
+
+    const bool fullBFS = std::any_of(batch.begin(), batch.end(), [](const Query& query) {
+        return query.algorithm == Algorithm::BFS && query.target == -1;
+    });
+    if (fullBFS && !loaded.reverse.has_value()) loaded.reverse = createReverseGraph(loaded.graph);
+
+    std::atomic<size_t> nextQuery = 0;
+    runThreads(threadCount, [&](int t) {
+        Result result;
+        for (size_t i = nextQuery++; i < batch.size(); i = nextQuery++) {
+            answer(loaded, batch[i], queryThreadCount, scratch[t], result);
+            outputs[i].clear();
+            if (options.binary)
+                writeBinary(batch[i], result, outputs[i]);
+            else
+                writeJson(batch[i], result, outputs[i]);
+        }
+    });
+
+    for (size_t i = 0; i < batch.size(); ++i)
+        std::fwrite(outputs[i].data(), 1, outputs[i].size(), stdout);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s GRAPH [--format json|binary] [--threads T] [--distance-unit U] "
+                     "[--hierarchy] [--query \"ALGORITHM SOURCE [TARGET]\"]...\n"
+                     "       %s GRAPH --all-pairs FILE [--threads T]\n",
+                     argv[0], argv[0]);
+        return 1;
+    }
+
+    std::optional<QueryGraph> loaded = loadQueryGraph(options);
+    if (!loaded.has_value()) return 1;
+    const Graph& graph = loaded->graph;
+
+    if (!options.allPairsPath.empty()) {
+        if (graph.vertexCount() > maxAllPairsVertices) {
+            std::fprintf(stderr, "%s: --all-pairs takes at most %d vertices, the graph has %d\n",
+                         options.graphPath.c_str(), maxAllPairsVertices, graph.vertexCount());
+            return 1;
+        }
+        DistanceMatrix matrix = AllPairsShortestPaths(graph, AllPairsMethod::Automatic,
+                                                      options.threads);
+        if (!saveDistanceMatrix(matrix, options.allPairsPath)) {
+            std::fprintf(stderr, "%s: could not write\n", options.allPairsPath.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    const int threadCount = resolveThreadCount(options.threads);
+    const size_t vertexCount = graph.vertexCount();
+    std::vector<Scratch> scratch(
+        threadCount, {std::vector<int>(vertexCount), std::vector<double>(vertexCount), {}});
+    if (loaded->hierarchy.has_value())
+        for (Scratch& threadScratch : scratch) threadScratch.hierarchy.emplace(*loaded->hierarchy);
+    std::vector<Query> batch;
+    std::vector<std::string> outputs;
+    bool malformed = false;
+
+    auto add = [&](std::string_view line, long lineNumber) {
+        std::string error;
+        if (auto query = parseQuery(line, graph, error)) {
+            batch.push_back(*query);
+            if (batch.size() == batchSize) {
+                runBatch(*loaded, batch, options, scratch, outputs);
+                batch.clear();
+            }
+        } else if (!error.empty()) {
+            std::fprintf(stderr, "query %ld: %s\n", lineNumber, error.c_str());
+            malformed = true;
+        }
+    };
+
+    if (!options.queries.empty()) {
+        for (size_t i = 0; i < options.queries.size(); ++i) add(options.queries[i], i + 1);
+    } else {
+        std::ios::sync_with_stdio(false);
+        std::string line;
+        for (long lineNumber = 1; std::getline(std::cin, line); ++lineNumber) add(line, lineNumber);
+    }
+    if (!batch.empty()) runBatch(*loaded, batch, options, scratch, outputs);
+
+    return malformed ? 1 : 0;
+}
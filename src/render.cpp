@@ -0,0 +1,239 @@
+#include "render.hpp"
+
+#include <rlgl.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+void drawLineBatch(const std::vector<Vector2>& segments, float thickness, const Color& color) {
+    // 6 vertices per segment, keeps a chunk well inside the default batch buffer
+    constexpr size_t pointsPerChunk = 2 * 1024;
+    const size_t pointCount = segments.size() - segments.size() % 2;
+    const float halfThickness = thickness / 2.0f;
+
+    for (size_t first = 0; first < pointCount; first += pointsPerChunk) {
+        size_t last = std::min(pointCount, first + pointsPerChunk);
+
+        rlCheckRenderBatchLimit(static_cast<int>(3 * (last - first)));
+        rlBegin(RL_TRIANGLES);
+        rlColor4ub(color.r, color.g, color.b, color.a);
+
+        for (size_t i = first; i < last; i += 2) {
+            const Vector2& from = segments[i];
+            const Vector2& to = segments[i + 1];
+
+            float dx = to.x - from.x;
+            float dy = to.y - from.y;
+            float length = std::sqrt(dx * dx + dy * dy);
+            if (length == 0.0f) continue;
+
+            // offset along the normal, corners in the same winding DrawLineEx uses
+            float nx = -dy / length * halfThickness;
+            float ny = dx / length * halfThickness;
+
+            rlVertex2f(from.x - nx, from.y - ny);
+            rlVertex2f(from.x + nx, from.y + ny);
+            rlVertex2f(to.x + nx, to.y + ny);
+
+            rlVertex2f(from.x - nx, from.y - ny);
+            rlVertex2f(to.x + nx, to.y + ny);
+            rlVertex2f(to.x - nx, to.y - ny);
+        }
+
+        rlEnd();
+    }
+}
+
+void drawPointBatch(const std::vector<Vector2>& points, const std::vector<Color>& colors,
+                    float size) {
+    // 4 vertices per point
+    constexpr size_t pointsPerChunk = 1024;
+    const float half = size / 2.0f;
+
+    for (size_t first = 0; first < points.size(); first += pointsPerChunk) {
+        size_t last = std::min(points.size(), first + pointsPerChunk);
+
+        rlCheckRenderBatchLimit(static_cast<int>(4 * (last - first)));
+        rlBegin(RL_QUADS);
+
+        for (size_t i = first; i < last; ++i) {
+            const Vector2& point = points[i];
+            const Color& color = colors[i];
+            rlColor4ub(color.r, color.g, color.b, color.a);
+
+            // counter-clockwise like DrawRectangle
+            rlVertex2f(point.x - half, point.y - half);
+            rlVertex2f(point.x - half, point.y + half);
+            rlVertex2f(point.x + half, point.y + half);
+            rlVertex2f(point.x + half, point.y - half);
+        }
+
+        rlEnd();
+    }
+}
+
+namespace {
+
+// Liang-Barsky, false when the segment misses the rectangle
+bool clipSegment(Vector2& from, Vector2& to, const Rectangle& rect) {
+    float dx = to.x - from.x;
+    float dy = to.y - from.y;
+    float enter = 0.0f, exit = 1.0f;
+
+    const std::pair<float, float> bounds[] = {{-dx, from.x - rect.x},
+                                              {dx, rect.x + rect.width - from.x},
+                                              {-dy, from.y - rect.y},
+                                              {dy, rect.y + rect.height - from.y}};
+    for (auto [p, q] : bounds) {
+        if (p == 0.0f) {
+            if (q < 0.0f) return false;
+        } else if (p < 0.0f) {
+            enter = std::max(enter, q / p);
+        } else {
+            exit = std::min(exit, q / p);
+        }
+    }
+    if (enter > exit) return false;
+
+    to = {from.x + exit * dx, from.y + exit * dy};
+    from = {from.x + enter * dx, from.y + enter * dy};
+    return true;
+}
+
+}  // namespace
+
+void aggregateSegments(const std::vector<Vector2>& segments, const Rectangle& view, float cellSize,
+                       std::vector<Vector2>& out) {
+    out.clear();
+
+    const int columns = static_cast<int>(view.width / cellSize) + 1;
+    const int rows = static_cast<int>(view.height / cellSize) + 1;
+    auto cellOf = [&](const Vector2& point) {
+        int column = std::clamp(static_cast<int>((point.x - view.x) / cellSize), 0, columns - 1);
+        int row = std::clamp(static_cast<int>((point.y - view.y) / cellSize), 0, rows - 1);
+        return static_cast<std::int64_t>(row) * columns + column;
+    };
+    auto centreOf = [&](std::int64_t cell) {
+        return Vector2{view.x + (static_cast<float>(cell % columns) + 0.5f) * cellSize,
+                       view.y + (static_cast<float>(cell / columns) + 0.5f) * cellSize};
+    };
+
+    std::unordered_set<std::int64_t> seen;
+    const size_t pointCount = segments.size() - segments.size() % 2;
+    for (size_t i = 0; i < pointCount; i += 2) {
+        Vector2 from = segments[i];
+        Vector2 to = segments[i + 1];
+        if (!clipSegment(from, to, view)) continue;
+
+        std::int64_t a = cellOf(from);
+        std::int64_t b = cellOf(to);
+        if (a == b) continue;
+        // direction doesn't matter for a line
+        if (a > b) std::swap(a, b);
+
+        if (!seen.insert(a * columns * rows + b).second) continue;
+        out.push_back(centreOf(a));
+        out.push_back(centreOf(b));
+    }
+}
+
+const GlyphRun& LabelCache::get(int key, std::string_view text) {
+    GlyphRun& run = this->runs[key];
+    if (run.text == text) return run;
+
+    run.text = text;
+    run.quads.clear();
+    run.uvs.clear();
+
+    // the same metrics DrawText and MeasureText use for the default font, which is drawn at
+    // least 10 pixels high with whole pixels between glyphs
+    const Font font = GetFontDefault();
+    const int size = std::max(this->fontSize, 10);
+    const float scale = static_cast<float>(size) / font.baseSize;
+    const float spacing = static_cast<float>(size / 10);
+    const float padding = static_cast<float>(font.glyphPadding);
+
+    float x = 0;
+    float width = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        // labels are typed one printable ascii character at a time
+        int glyph = GetGlyphIndex(font, static_cast<unsigned char>(text[i]));
+        const GlyphInfo& info = font.glyphs[glyph];
+        const Rectangle& source = font.recs[glyph];
+
+        if (text[i] != ' ' && text[i] != '\t') {
+            run.quads.push_back({x + (info.offsetX - padding) * scale,
+                                 (info.offsetY - padding) * scale,
+                                 (source.width + 2 * padding) * scale,
+                                 (source.height + 2 * padding) * scale});
+            run.uvs.push_back({(source.x - padding) / font.texture.width,
+                               (source.y - padding) / font.texture.height,
+                               (source.width + 2 * padding) / font.texture.width,
+                               (source.height + 2 * padding) / font.texture.height});
+        }
+
+        if (info.advanceX != 0) {
+            width += info.advanceX;
+            x += info.advanceX * scale + spacing;
+        } else {
+            width += source.width + info.offsetX;
+            x += source.width * scale + spacing;
+        }
+    }
+    run.width = text.empty() ? 0 : static_cast<int>(width * scale + (text.size() - 1) * spacing);
+    return run;
+}
+
+void TextBatch::add(const GlyphRun& run, Vector2 origin, Color color) {
+    if (!run.quads.empty()) this->entries.push_back({&run, origin, color});
+}
+
+void TextBatch::draw() {
+    // 4 vertices per glyph
+    constexpr int glyphsPerChunk = 1024;
+
+    rlSetTexture(GetFontDefault().texture.id);
+    bool begun = false;
+    int glyphsInChunk = 0;
+    for (const Entry& entry : this->entries) {
+        const GlyphRun& run = *entry.run;
+        for (size_t i = 0; i < run.quads.size(); ++i) {
+            if (!begun || glyphsInChunk == glyphsPerChunk) {
+                if (begun) rlEnd();
+                rlCheckRenderBatchLimit(4 * glyphsPerChunk);
+                rlBegin(RL_QUADS);
+                rlNormal3f(0, 0, 1);
+                begun = true;
+                glyphsInChunk = 0;
+            }
+            ++glyphsInChunk;
+
+            // pixel aligned like DrawText, which takes integer positions
+            const Rectangle& quad = run.quads[i];
+            const Rectangle& uv = run.uvs[i];
+            const float x = std::trunc(entry.origin.x) + quad.x;
+            const float y = std::trunc(entry.origin.y) + quad.y;
+            rlColor4ub(entry.color.r, entry.color.g, entry.color.b, entry.color.a);
+
+            // counter-clockwise from the top left like DrawTexturePro
+            rlTexCoord2f(uv.x, uv.y);
+            rlVertex2f(x, y);
+            rlTexCoord2f(uv.x, uv.y + uv.height);
+            rlVertex2f(x, y + quad.height);
+            rlTexCoord2f(uv.x + uv.width, uv.y + uv.height);
+            rlVertex2f(x + quad.width, y + quad.height);
+            rlTexCoord2f(uv.x + uv.width, uv.y);
+            rlVertex2f(x + quad.width, y);
+        }
+    }
+    if (begun) rlEnd();
+    rlSetTexture(0);
+
+    this->entries.clear();
+}
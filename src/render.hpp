@@ -0,0 +1,74 @@
+#ifndef RENDER_HPP
+#define RENDER_HPP
+
+#include <raylib.h>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Draws consecutive point pairs as thick lines, submitted as triangles in as few rlgl batches as
+// the batch buffer allows instead of one DrawLineEx call per segment.
+void drawLineBatch(const std::vector<Vector2>& segments, float thickness, const Color& color);
+
+// Draws each point as a size x size square centred on it, colors[i] for points[i], batched like
+// drawLineBatch. Used instead of circles when vertices are only a few pixels wide.
+void drawPointBatch(const std::vector<Vector2>& points, const std::vector<Color>& colors,
+                    float size);
+
+// Level of detail for edges: clips the segment pairs to view, snaps both ends to a grid of
+// cellSize and keeps one segment per distinct pair of cells, between the cell centres. Segments
+// that start and end in the same cell are dropped. The result replaces out and is bounded by the
+// number of cell pairs in view instead of the number of edges.
+void aggregateSegments(const std::vector<Vector2>& segments, const Rectangle& view, float cellSize,
+                       std::vector<Vector2>& out);
+
+// A string laid out once in the default font, what DrawText would draw for it: one quad per
+// glyph relative to the text origin with its texture coordinates in the font atlas.
+struct GlyphRun {
+    std::string text;
+    // what MeasureText returns for text
+    int width = 0;
+    std::vector<Rectangle> quads;
+    std::vector<Rectangle> uvs;
+};
+
+// Glyph runs of labels at one font size, keyed by whatever owns the label (a vertex or edge id).
+// A run is laid out again only when its text has changed since the last lookup, so unchanged
+// labels cost a string compare instead of a measurement. Needs the window, the default font is
+// loaded with it.
+class LabelCache {
+   public:
+    explicit LabelCache(int fontSize) : fontSize(fontSize) {}
+
+    const GlyphRun& get(int key, std::string_view text);
+    // drops the run of a key that is gone, get() would only lay it out again if it came back
+    inline void erase(int key) { this->runs.erase(key); }
+    // drops every run, for when keys are reused for other labels wholesale
+    inline void clear() { this->runs.clear(); }
+
+   private:
+    int fontSize;
+    std::unordered_map<int, GlyphRun> runs;
+};
+
+// Collects glyph runs and draws them all as textured quads in one batch on the font atlas
+// instead of one DrawText call, and texture switch, per label.
+class TextBatch {
+   public:
+    // the run has to outlive the next draw()
+    void add(const GlyphRun& run, Vector2 origin, Color color);
+    // draws and empties the batch
+    void draw();
+
+   private:
+    struct Entry {
+        const GlyphRun* run;
+        Vector2 origin;
+        Color color;
+    };
+    std::vector<Entry> entries;
+};
+
+#endif  // RENDER_HPP
@@ -0,0 +1,295 @@
+#include "spatialindex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace {
+
+float distanceToSegment(const Vector2& point, const Vector2& from, const Vector2& to) {
+    float dx = to.x - from.x;
+    float dy = to.y - from.y;
+    float lengthSquared = dx * dx + dy * dy;
+
+    float t = 0.0f;
+    if (lengthSquared > 0.0f) {
+        t = ((point.x - from.x) * dx + (point.y - from.y) * dy) / lengthSquared;
+        t = std::clamp(t, 0.0f, 1.0f);
+    }
+
+    return std::hypot(point.x - (from.x + t * dx), point.y - (from.y + t * dy));
+}
+
+bool circleOverlapsRect(const Vector2& center, float radius, const Rectangle& rect) {
+    float nearestX = std::clamp(center.x, rect.x, rect.x + rect.width);
+    float nearestY = std::clamp(center.y, rect.y, rect.y + rect.height);
+    float dx = center.x - nearestX;
+    float dy = center.y - nearestY;
+    return dx * dx + dy * dy <= radius * radius;
+}
+
+void eraseFromCell(std::unordered_map<std::int64_t, std::vector<int>>& cells, std::int64_t key,
+                   int id) {
+    auto cell = cells.find(key);
+    if (cell == cells.end()) return;
+
+    auto& ids = cell->second;
+    auto it = std::find(ids.begin(), ids.end(), id);
+    if (it != ids.end()) {
+        *it = ids.back();
+        ids.pop_back();
+    }
+    if (ids.empty()) cells.erase(cell);
+}
+
+void sortUnique(std::vector<int>& ids) {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+// an edge goes to the first level where its padded extent covers at most this many cells per axis
+constexpr float maxEdgeSpan = 4.0f;
+constexpr int maxLevel = 30;
+
+}  // namespace
+
+SpatialIndex::SpatialIndex(float cellSize, float edgeMargin) {
+    this->cellSize = cellSize;
+    this->edgeMargin = edgeMargin;
+}
+
+int SpatialIndex::cellOf(float coordinate) const {
+    return static_cast<int>(std::floor(coordinate / this->cellSize));
+}
+
+int SpatialIndex::cellOf(float coordinate, int level) const {
+    return static_cast<int>(std::floor(coordinate / std::ldexp(this->cellSize, level)));
+}
+
+int SpatialIndex::levelOf(const Vector2& from, const Vector2& to) const {
+    float extent =
+        std::max(std::abs(to.x - from.x), std::abs(to.y - from.y)) + 2 * this->edgeMargin;
+    int level = 0;
+    while (level < maxLevel && extent > maxEdgeSpan * std::ldexp(this->cellSize, level)) ++level;
+    return level;
+}
+
+std::int64_t SpatialIndex::key(int cellX, int cellY) {
+    return (static_cast<std::int64_t>(cellX) << 32) ^ static_cast<std::uint32_t>(cellY);
+}
+
+template <typename Visit>
+void SpatialIndex::forEachEdgeCell(const EdgeEntry& entry, Visit visit) const {
+    const float padding = this->edgeMargin;
+
+    Vector2 left = entry.from;
+    Vector2 right = entry.to;
+    if (left.x > right.x) std::swap(left, right);
+    const float dx = right.x - left.x;
+
+    const int level = entry.level;
+    const float size = std::ldexp(this->cellSize, level);
+
+    // walk the columns the padded segment crosses and only the rows it spans inside each one,
+    // a long diagonal edge touches O(length) cells instead of its whole bounding box
+    for (int x = this->cellOf(left.x - padding, level); x <= this->cellOf(right.x + padding, level);
+         ++x) {
+        float columnStart = std::max(left.x, x * size - padding);
+        float columnEnd = std::min(right.x, (x + 1) * size + padding);
+
+        float startY = left.y, endY = right.y;
+        if (dx > 0.0f) {
+            startY = left.y + (right.y - left.y) * (columnStart - left.x) / dx;
+            endY = left.y + (right.y - left.y) * (columnEnd - left.x) / dx;
+        }
+
+        int minY = this->cellOf(std::min(startY, endY) - padding, level);
+        int maxY = this->cellOf(std::max(startY, endY) + padding, level);
+        for (int y = minY; y <= maxY; ++y) visit(key(x, y));
+    }
+}
+
+void SpatialIndex::insertVertex(int id, const Vector2& pos, float radius) {
+    this->removeVertex(id);
+    this->vertexEntries[id] = {pos, radius};
+
+    for (int x = this->cellOf(pos.x - radius); x <= this->cellOf(pos.x + radius); ++x)
+        for (int y = this->cellOf(pos.y - radius); y <= this->cellOf(pos.y + radius); ++y)
+            this->vertexCells[key(x, y)].push_back(id);
+}
+
+void SpatialIndex::removeVertex(int id) {
+    auto entry = this->vertexEntries.find(id);
+    if (entry == this->vertexEntries.end()) return;
+
+    const auto& [pos, radius] = entry->second;
+    for (int x = this->cellOf(pos.x - radius); x <= this->cellOf(pos.x + radius); ++x)
+        for (int y = this->cellOf(pos.y - radius); y <= this->cellOf(pos.y + radius); ++y)
+            eraseFromCell(this->vertexCells, key(x, y), id);
+
+    this->vertexEntries.erase(entry);
+}
+
+void SpatialIndex::insertEdge(int id, const Vector2& from, const Vector2& to) {
+    this->removeEdge(id);
+    EdgeEntry& entry = this->edgeEntries[id] = {from, to, this->nextStamp++, 0,
+                                                this->levelOf(from, to)};
+    if (entry.level >= static_cast<int>(this->edgeCells.size()))
+        this->edgeCells.resize(entry.level + 1);
+
+    auto& cells = this->edgeCells[entry.level];
+    this->forEachEdgeCell(entry, [&cells, id, &entry](std::int64_t cell) {
+        cells[cell].push_back({id, entry.stamp});
+        ++entry.cellCount;
+    });
+    this->liveEdgeRefs += entry.cellCount;
+}
+
+void SpatialIndex::removeEdge(int id) {
+    auto entry = this->edgeEntries.find(id);
+    if (entry == this->edgeEntries.end()) return;
+
+    this->liveEdgeRefs -= entry->second.cellCount;
+    this->staleEdgeRefs += entry->second.cellCount;
+    this->edgeEntries.erase(entry);
+
+    if (this->staleEdgeRefs > this->liveEdgeRefs + 4096) this->sweepEdgeCells();
+}
+
+void SpatialIndex::clear() {
+    this->vertexCells.clear();
+    this->edgeCells.clear();
+    this->vertexEntries.clear();
+    this->edgeEntries.clear();
+    this->liveEdgeRefs = 0;
+    this->staleEdgeRefs = 0;
+}
+
+const SpatialIndex::EdgeEntry* SpatialIndex::liveEdge(const EdgeRef& ref) const {
+    auto entry = this->edgeEntries.find(ref.id);
+    if (entry == this->edgeEntries.end() || entry->second.stamp != ref.stamp) return nullptr;
+    return &entry->second;
+}
+
+void SpatialIndex::sweepEdgeCells() {
+    for (auto& cells : this->edgeCells) {
+        for (auto cell = cells.begin(); cell != cells.end();) {
+            auto& refs = cell->second;
+            refs.erase(std::remove_if(refs.begin(), refs.end(),
+                                      [this](const EdgeRef& ref) { return !this->liveEdge(ref); }),
+                       refs.end());
+            cell = refs.empty() ? cells.erase(cell) : std::next(cell);
+        }
+    }
+    this->staleEdgeRefs = 0;
+}
+
+int SpatialIndex::vertexAt(const Vector2& point) const {
+    auto cell = this->vertexCells.find(key(this->cellOf(point.x), this->cellOf(point.y)));
+    if (cell == this->vertexCells.end()) return -1;
+
+    int hit = -1;
+    for (int id : cell->second) {
+        const auto& [pos, radius] = this->vertexEntries.at(id);
+        float dx = point.x - pos.x;
+        float dy = point.y - pos.y;
+        if (dx * dx + dy * dy <= radius * radius && (hit == -1 || id < hit)) hit = id;
+    }
+
+    return hit;
+}
+
+int SpatialIndex::edgeAt(const Vector2& point, float tolerance) const {
+    int hit = -1;
+    for (int level = 0; level < static_cast<int>(this->edgeCells.size()); ++level) {
+        const auto& cells = this->edgeCells[level];
+        auto cell = cells.find(key(this->cellOf(point.x, level), this->cellOf(point.y, level)));
+        if (cell == cells.end()) continue;
+
+        for (const EdgeRef& ref : cell->second) {
+            const EdgeEntry* entry = this->liveEdge(ref);
+            if (entry != nullptr && distanceToSegment(point, entry->from, entry->to) <= tolerance &&
+                (hit == -1 || ref.id < hit))
+                hit = ref.id;
+        }
+    }
+
+    return hit;
+}
+
+bool SpatialIndex::overlapsVertex(const Vector2& center, float radius) const {
+    for (int id : this->verticesIn({center.x - radius, center.y - radius, 2 * radius, 2 * radius})) {
+        const auto& entry = this->vertexEntries.at(id);
+        if (std::hypot(center.x - entry.pos.x, center.y - entry.pos.y) < radius + entry.radius)
+            return true;
+    }
+    return false;
+}
+
+std::vector<int> SpatialIndex::verticesIn(const Rectangle& rect) const {
+    std::vector<int> ids;
+
+    int minX = this->cellOf(rect.x), maxX = this->cellOf(rect.x + rect.width);
+    int minY = this->cellOf(rect.y), maxY = this->cellOf(rect.y + rect.height);
+
+    // a rectangle covering more cells than there are vertices is cheaper to answer by scanning
+    double cellCount = (static_cast<double>(maxX) - minX + 1) * (static_cast<double>(maxY) - minY + 1);
+    if (cellCount > static_cast<double>(this->vertexEntries.size())) {
+        for (const auto& [id, entry] : this->vertexEntries)
+            if (circleOverlapsRect(entry.pos, entry.radius, rect)) ids.push_back(id);
+    } else {
+        for (int x = minX; x <= maxX; ++x) {
+            for (int y = minY; y <= maxY; ++y) {
+                auto cell = this->vertexCells.find(key(x, y));
+                if (cell == this->vertexCells.end()) continue;
+                for (int id : cell->second) {
+                    const auto& entry = this->vertexEntries.at(id);
+                    if (circleOverlapsRect(entry.pos, entry.radius, rect)) ids.push_back(id);
+                }
+            }
+        }
+    }
+
+    sortUnique(ids);
+    return ids;
+}
+
+std::vector<int> SpatialIndex::edgesIn(const Rectangle& rect) const {
+    std::vector<int> ids;
+
+    int minX = this->cellOf(rect.x), maxX = this->cellOf(rect.x + rect.width);
+    int minY = this->cellOf(rect.y), maxY = this->cellOf(rect.y + rect.height);
+
+    // cells are a conservative filter, an edge passing near the rectangle may still be returned
+    double cellCount = (static_cast<double>(maxX) - minX + 1) * (static_cast<double>(maxY) - minY + 1);
+    if (cellCount > static_cast<double>(this->edgeEntries.size())) {
+        for (const auto& [id, entry] : this->edgeEntries) {
+            Rectangle bounds{std::min(entry.from.x, entry.to.x), std::min(entry.from.y, entry.to.y),
+                             std::abs(entry.to.x - entry.from.x),
+                             std::abs(entry.to.y - entry.from.y)};
+            if (bounds.x <= rect.x + rect.width && rect.x <= bounds.x + bounds.width &&
+                bounds.y <= rect.y + rect.height && rect.y <= bounds.y + bounds.height)
+                ids.push_back(id);
+        }
+    } else {
+        for (int level = 0; level < static_cast<int>(this->edgeCells.size()); ++level) {
+            const auto& cells = this->edgeCells[level];
+            for (int x = this->cellOf(rect.x, level); x <= this->cellOf(rect.x + rect.width, level);
+                 ++x) {
+                for (int y = this->cellOf(rect.y, level);
+                     y <= this->cellOf(rect.y + rect.height, level); ++y) {
+                    auto cell = cells.find(key(x, y));
+                    if (cell == cells.end()) continue;
+                    for (const EdgeRef& ref : cell->second)
+                        if (this->liveEdge(ref) != nullptr) ids.push_back(ref.id);
+                }
+            }
+        }
+    }
+
+    sortUnique(ids);
+    return ids;
+}
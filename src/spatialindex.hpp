@@ -0,0 +1,75 @@
+#ifndef SPATIALINDEX_HPP
+#define SPATIALINDEX_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "types.hpp"
+
+// Uniform grid over vertex discs and edge segments used for picking. Every object is registered
+// in each cell it overlaps (edges padded by edgeMargin), so a point query only looks at the
+// handful of objects sharing its cell. Edges go into a hierarchy of grids whose cells double in
+// size per level, each at the first level where it spans at most maxEdgeSpan cells, so a long
+// edge costs a few cells instead of one per cellSize of its length; point queries look at one
+// cell per level. Removing an edge only drops its entry; the stale cell references are skipped
+// by queries and swept out once they outnumber the live ones.
+class SpatialIndex {
+   public:
+    explicit SpatialIndex(float cellSize = 64.0f, float edgeMargin = 16.0f);
+
+    void insertVertex(int id, const Vector2& pos, float radius);
+    void removeVertex(int id);
+    void insertEdge(int id, const Vector2& from, const Vector2& to);
+    void removeEdge(int id);
+    void clear();
+
+    // lowest id hit, -1 when nothing is under the point. tolerance must not exceed edgeMargin
+    int vertexAt(const Vector2& point) const;
+    int edgeAt(const Vector2& point, float tolerance) const;
+
+    bool overlapsVertex(const Vector2& center, float radius) const;
+    std::vector<int> verticesIn(const Rectangle& rect) const;
+    std::vector<int> edgesIn(const Rectangle& rect) const;
+
+   private:
+    struct VertexEntry {
+        Vector2 pos;
+        float radius;
+    };
+    struct EdgeEntry {
+        Vector2 from;
+        Vector2 to;
+        unsigned stamp;
+        int cellCount;
+        int level;
+    };
+    struct EdgeRef {
+        int id;
+        unsigned stamp;
+    };
+
+    float cellSize;
+    float edgeMargin;
+
+    std::unordered_map<std::int64_t, std::vector<int>> vertexCells;
+    // edgeCells[level] has cells of cellSize * 2^level
+    std::vector<std::unordered_map<std::int64_t, std::vector<EdgeRef>>> edgeCells;
+    std::unordered_map<int, VertexEntry> vertexEntries;
+    std::unordered_map<int, EdgeEntry> edgeEntries;
+    unsigned nextStamp = 0;
+    long liveEdgeRefs = 0;
+    long staleEdgeRefs = 0;
+
+    int cellOf(float coordinate) const;
+    int cellOf(float coordinate, int level) const;
+    int levelOf(const Vector2& from, const Vector2& to) const;
+    const EdgeEntry* liveEdge(const EdgeRef& ref) const;
+    void sweepEdgeCells();
+    static std::int64_t key(int cellX, int cellY);
+
+    template <typename Visit>
+    void forEachEdgeCell(const EdgeEntry& entry, Visit visit) const;
+};
+
+#endif  // SPATIALINDEX_HPP
@@ -0,0 +1,157 @@
+#include "traversal.hpp"
+
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+BFSTraversal::BFSTraversal(const Graph& graph, int startVertex) {
+    this->graph = &graph;
+    if (!graph.contains(startVertex)) return;
+
+    this->visited.assign(graph.vertexCount(), false);
+    this->visited[startVertex] = true;
+    this->frontier.push({startVertex, 0});
+}
+
+std::optional<TraversalStep> BFSTraversal::next() {
+    if (this->frontier.empty()) return std::nullopt;
+
+    auto [current, level] = this->frontier.front();
+    this->frontier.pop();
+
+    for (int i = this->graph->offsets[current]; i < this->graph->offsets[current + 1]; ++i) {
+        int adjacent = this->graph->targets[i];
+        if (!this->visited[adjacent]) {
+            this->visited[adjacent] = true;
+            this->frontier.push({adjacent, level + 1});
+        }
+    }
+
+    return TraversalStep{TraversalStep::Kind::Visit, current, static_cast<double>(level)};
+}
+
+DFSTraversal::DFSTraversal(const Graph& graph, int startVertex) {
+    this->graph = &graph;
+    if (!graph.contains(startVertex)) return;
+
+    this->visited.assign(graph.vertexCount(), false);
+    this->visited[startVertex] = true;
+    this->frontier.push_back({startVertex, 0});
+}
+
+std::optional<TraversalStep> DFSTraversal::next() {
+    if (this->frontier.empty()) return std::nullopt;
+
+    auto [current, depth] = this->frontier.back();
+    this->frontier.pop_back();
+
+    for (int i = this->graph->offsets[current]; i < this->graph->offsets[current + 1]; ++i) {
+        int adjacent = this->graph->targets[i];
+        if (!this->visited[adjacent]) {
+            this->visited[adjacent] = true;
+            this->frontier.push_back({adjacent, depth + 1});
+        }
+    }
+
+    return TraversalStep{TraversalStep::Kind::Visit, current, static_cast<double>(depth)};
+}
+
+DijkstraTraversal::DijkstraTraversal(const Graph& graph, int startVertex) {
+    this->graph = &graph;
+    if (!graph.contains(startVertex)) return;
+
+    this->dist.assign(graph.vertexCount(), std::numeric_limits<double>::infinity());
+    this->dist[startVertex] = 0;
+    this->pq.push({0, startVertex});
+}
+
+std::optional<TraversalStep> DijkstraTraversal::next() {
+    // finish relaxing the out-edges of the last visited vertex before visiting the next one
+    while (this->current != -1) {
+        if (this->edgeCursor == this->graph->offsets[this->current + 1]) {
+            this->current = -1;
+            break;
+        }
+
+        int i = this->edgeCursor++;
+        double weight = this->graph->isWeighted() ? this->graph->weights[i] : 1;
+        int adjacent = this->graph->targets[i];
+
+        if (this->dist[this->current] + weight < this->dist[adjacent]) {
+            this->dist[adjacent] = this->dist[this->current] + weight;
+            this->pq.push({this->dist[adjacent], adjacent});
+            return TraversalStep{TraversalStep::Kind::Relax, adjacent, this->dist[adjacent]};
+        }
+    }
+
+    while (!this->pq.empty()) {
+        auto [dis, vertex] = this->pq.top();
+        this->pq.pop();
+        if (dis > this->dist[vertex]) continue;
+
+        this->current = vertex;
+        this->edgeCursor = this->graph->offsets[vertex];
+        return TraversalStep{TraversalStep::Kind::Visit, vertex, dis};
+    }
+
+    return std::nullopt;
+}
+
+AStarTraversal::AStarTraversal(const Graph& graph, std::vector<Vector2> positions, int startVertex,
+                               int targetVertex, double distanceUnit)
+    : positions(std::move(positions)), target(targetVertex), distanceUnit(distanceUnit) {
+    this->graph = &graph;
+    if (!graph.contains(startVertex) || !graph.contains(targetVertex)) return;
+
+    this->dist.assign(graph.vertexCount(), std::numeric_limits<double>::infinity());
+    this->closed.assign(graph.vertexCount(), false);
+    this->dist[startVertex] = 0;
+    this->pq.push({this->estimate(startVertex), startVertex});
+}
+
+double AStarTraversal::estimate(int vertex) const {
+    const Vector2& from = this->positions[vertex];
+    const Vector2& to = this->positions[this->target];
+    return std::hypot(to.x - from.x, to.y - from.y) / this->distanceUnit;
+}
+
+std::optional<TraversalStep> AStarTraversal::next() {
+    while (this->current != -1) {
+        if (this->edgeCursor == this->graph->offsets[this->current + 1]) {
+            this->current = -1;
+            break;
+        }
+
+        int i = this->edgeCursor++;
+        double weight = this->graph->isWeighted() ? this->graph->weights[i] : 1;
+        int adjacent = this->graph->targets[i];
+
+        if (!this->closed[adjacent] && this->dist[this->current] + weight < this->dist[adjacent]) {
+            this->dist[adjacent] = this->dist[this->current] + weight;
+            this->pq.push({this->dist[adjacent] + this->estimate(adjacent), adjacent});
+            return TraversalStep{TraversalStep::Kind::Relax, adjacent, this->dist[adjacent]};
+        }
+    }
+
+    while (!this->pq.empty()) {
+        auto [priority, vertex] = this->pq.top();
+        this->pq.pop();
+        // the same sum as when it was pushed, so only the entry of the latest relax matches
+        if (this->closed[vertex] || priority > this->dist[vertex] + this->estimate(vertex))
+            continue;
+        this->closed[vertex] = true;
+
+        if (vertex == this->target) {
+            // nothing after the target, its out-edges aren't needed
+            this->pq = {};
+        } else {
+            this->current = vertex;
+            this->edgeCursor = this->graph->offsets[vertex];
+        }
+        return TraversalStep{TraversalStep::Kind::Visit, vertex, this->dist[vertex]};
+    }
+
+    return std::nullopt;
+}
@@ -0,0 +1,112 @@
+#ifndef TRAVERSAL_HPP
+#define TRAVERSAL_HPP
+
+#include <optional>
+#include <queue>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "graph.hpp"
+#include "types.hpp"
+
+// Visit: vertex leaves the frontier, distance is the BFS level, DFS tree depth or final Dijkstra
+// distance
+// Relax: Dijkstra lowered the tentative distance of vertex to distance through the last visit
+struct TraversalStep {
+    enum class Kind { Visit, Relax };
+
+    Kind kind;
+    int vertex;
+    double distance;
+};
+
+// Resumable traversals that produce one step per next() call and nullopt once exhausted. They
+// visit vertices in exactly the order of BFS, DFS and Dijkstra in util.hpp, but only hold the
+// visited flags and the current frontier, so starting one is O(V) bits no matter how large the
+// graph is. The graph must outlive the traversal and stay unchanged while it runs.
+class BFSTraversal {
+   public:
+    BFSTraversal(const Graph&, int startVertex);
+    std::optional<TraversalStep> next();
+
+   private:
+    const Graph* graph;
+    std::vector<bool> visited;
+    // (vertex, level)
+    std::queue<std::pair<int, int>> frontier;
+};
+
+class DFSTraversal {
+   public:
+    DFSTraversal(const Graph&, int startVertex);
+    std::optional<TraversalStep> next();
+
+   private:
+    const Graph* graph;
+    std::vector<bool> visited;
+    // (vertex, depth)
+    std::vector<std::pair<int, int>> frontier;
+};
+
+class DijkstraTraversal {
+   public:
+    DijkstraTraversal(const Graph&, int startVertex);
+    std::optional<TraversalStep> next();
+
+   private:
+    struct Compare {
+        constexpr bool operator()(const std::pair<double, int>& lhs,
+                                  const std::pair<double, int>& rhs) const {
+            return lhs.first > rhs.first;
+        }
+    };
+
+    const Graph* graph;
+    std::vector<double> dist;
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, Compare> pq;
+    // the visited vertex whose out-edges are being relaxed, -1 between visits
+    int current = -1;
+    int edgeCursor = 0;
+};
+
+// Dijkstra towards one target, ordered by the distance so far plus the straight-line distance
+// from the vertex's position to the target's divided by distanceUnit, so it heads for the target
+// instead of spreading out evenly. Stops once the target is visited. A visited vertex is closed
+// and never relaxed or visited again, so it takes at most V visits whatever the weights.
+// positions has one entry per vertex; see AStar in util.hpp for when the distances are exact.
+class AStarTraversal {
+   public:
+    AStarTraversal(const Graph&, std::vector<Vector2> positions, int startVertex, int targetVertex,
+                   double distanceUnit);
+    std::optional<TraversalStep> next();
+
+   private:
+    struct Compare {
+        constexpr bool operator()(const std::pair<double, int>& lhs,
+                                  const std::pair<double, int>& rhs) const {
+            return lhs.first > rhs.first;
+        }
+    };
+
+    const Graph* graph;
+    std::vector<Vector2> positions;
+    int target;
+    double distanceUnit;
+    std::vector<double> dist;
+    std::vector<bool> closed;
+    // (distance + heuristic, vertex)
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, Compare> pq;
+    int current = -1;
+    int edgeCursor = 0;
+
+    double estimate(int vertex) const;
+};
+
+using Traversal = std::variant<BFSTraversal, DFSTraversal, DijkstraTraversal, AStarTraversal>;
+
+inline std::optional<TraversalStep> nextStep(Traversal& traversal) {
+    return std::visit([](auto& active) { return active.next(); }, traversal);
+}
+
+#endif  // TRAVERSAL_HPP
@@ -0,0 +1,30 @@
+#ifndef TYPES_HPP
+#define TYPES_HPP
+
+// The core library only uses raylib's plain value types. Take raylib's own definitions when its
+// header is around so the app and the core share them, otherwise declare layout-identical copies
+// so the core also builds on machines without raylib.
+#if __has_include(<raylib.h>)
+#include <raylib.h>
+#else
+typedef struct Vector2 {
+    float x;
+    float y;
+} Vector2;
+
+typedef struct Color {
+    unsigned char r;
+    unsigned char g;
+    unsigned char b;
+    unsigned char a;
+} Color;
+
+typedef struct Rectangle {
+    float x;
+    float y;
+    float width;
+    float height;
+} Rectangle;
+#endif
+
+#endif  // TYPES_HPP
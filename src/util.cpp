@@ -1,173 +1,245 @@
 #include "util.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <limits>
-#include <map>
+#include <numeric>
 #include <optional>
 #include <queue>
 #include <stack>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <thread>
 #include <utility>
 #include <variant>
 #include <vector>
 
-std::unordered_map<std::string, std::vector<std::string>> createAdjacencyMap(
-    const std::vector<Vertex>& vertices, const std::vector<Edge>& edges) {
-    std::unordered_map<std::string, std::vector<std::string>> adjacencyMap;
+namespace {
 
-    std::unordered_map<int, const Vertex*> vertexMap;
-    for (const auto& vertex : vertices) {
-        if (vertex.usable) vertexMap[vertex.id] = &vertex;
-    }
-
-    adjacencyMap.reserve(edges.size());
+// Maps vertex ids to positions in the vertices vector, -1 for unusable vertices
+std::vector<int> createIndexTable(const std::vector<Vertex>& vertices) {
+    int maxId = -1;
+    for (const auto& vertex : vertices) maxId = std::max(maxId, vertex.id);
 
-    for (const Edge& edge : edges) {
-        auto fromIter = vertexMap.find(edge.fromId);
-        auto toIter = vertexMap.find(edge.toId);
-
-        if (fromIter != vertexMap.end() && toIter != vertexMap.end()) {
-            adjacencyMap[fromIter->second->label].push_back(toIter->second->label);
-        }
+    std::vector<int> indexOf(maxId + 1, -1);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        if (vertices[i].usable) indexOf[vertices[i].id] = static_cast<int>(i);
     }
 
-    return adjacencyMap;
+    return indexOf;
 }
 
-std::unordered_map<std::string, std::vector<std::pair<int, std::string>>>
-createAdjacencyMapWeighted(const std::vector<Vertex>& vertices, const std::vector<Edge>& edges) {
-    std::unordered_map<std::string, std::vector<std::pair<int, std::string>>> adjacencyMap;
+Graph createGraph(const std::vector<Vertex>& vertices, const std::vector<Edge>& edges,
+                  bool weighted) {
+    auto indexOf = createIndexTable(vertices);
+    auto lookup = [&indexOf](int id) {
+        return id >= 0 && id < static_cast<int>(indexOf.size()) ? indexOf[id] : -1;
+    };
 
-    std::unordered_map<int, const Vertex*> vertexMap;
-    for (const auto& vertex : vertices) {
-        if (vertex.usable) {
-            vertexMap[vertex.id] = &vertex;
-            if (adjacencyMap[vertex.label].empty()) {
-                adjacencyMap[vertex.label] = {};
-            }
-        }
+    Graph graph;
+    graph.offsets.assign(vertices.size() + 1, 0);
+    auto offsets = graph.offsets.writable();
+
+    for (const Edge& edge : edges) {
+        int from = lookup(edge.fromId);
+        if (from != -1 && lookup(edge.toId) != -1) ++offsets[from + 1];
     }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
 
+    graph.targets.resize(graph.offsets.back());
+    if (weighted) graph.weights.resize(graph.offsets.back());
+    auto targets = graph.targets.writable();
+    auto weights = graph.weights.writable();
+
+    // edges keep their insertion order within a row so traversal order matches the edge list
+    std::vector<int> cursor(graph.offsets.begin(), graph.offsets.end() - 1);
     for (const Edge& edge : edges) {
-        auto fromIter = vertexMap.find(edge.fromId);
-        auto toIter = vertexMap.find(edge.toId);
+        int from = lookup(edge.fromId);
+        int to = lookup(edge.toId);
 
-        if (fromIter != vertexMap.end() && toIter != vertexMap.end()) {
-            adjacencyMap[fromIter->second->label].push_back(
-                {std::stoi(edge.weight), toIter->second->label});
+        if (from != -1 && to != -1) {
+            int slot = cursor[from]++;
+            targets[slot] = to;
+            if (weighted) weights[slot] = edge.weight.asDouble();
         }
     }
 
-    return adjacencyMap;
+    return graph;
 }
 
-std::vector<std::string> BFS(
-    const std::unordered_map<std::string, std::vector<std::string>>& adjacencyMap,
-    const std::string& startVertex) {
-    std::unordered_set<std::string> visited;
-    std::queue<std::string> q;
-    std::string current;
-    std::vector<std::string> returnVec;
+}  // namespace
 
-    q.push(startVertex);
-    visited.insert(startVertex);
+Graph createGraph(const std::vector<Vertex>& vertices, const std::vector<Edge>& edges) {
+    return createGraph(vertices, edges, false);
+}
 
-    while (!q.empty()) {
-        current = q.front();
-        q.pop();
+Graph createGraphWeighted(const std::vector<Vertex>& vertices, const std::vector<Edge>& edges) {
+    return createGraph(vertices, edges, true);
+}
 
-        returnVec.push_back(current);
+std::vector<int> BFS(const Graph& graph, int startVertex) {
+    std::vector<int> returnVec;
+    if (!graph.contains(startVertex)) return returnVec;
+
+    std::vector<bool> visited(graph.vertexCount(), false);
 
-        if (adjacencyMap.find(current) != adjacencyMap.end())
-            for (const auto& adjacent : adjacencyMap.at(current)) {
-                if (visited.emplace(adjacent).second) {
-                    q.push(adjacent);
-                }
+    // the visit order doubles as the queue, head is the next vertex to expand
+    returnVec.push_back(startVertex);
+    visited[startVertex] = true;
+
+    for (size_t head = 0; head < returnVec.size(); ++head) {
+        int current = returnVec[head];
+
+        for (int i = graph.offsets[current]; i < graph.offsets[current + 1]; ++i) {
+            int adjacent = graph.targets[i];
+            if (!visited[adjacent]) {
+                visited[adjacent] = true;
+                returnVec.push_back(adjacent);
             }
+        }
     }
 
     return returnVec;
 }
 
-std::vector<std::string> DFS(
-    const std::unordered_map<std::string, std::vector<std::string>>& adjacencyMap,
-    const std::string& startVertex) {
-    std::unordered_set<std::string> visited;
-    std::stack<std::string> st;
-    std::string current;
-    std::vector<std::string> returnVec;
+std::vector<int> DFS(const Graph& graph, int startVertex) {
+    std::vector<int> returnVec;
+    if (!graph.contains(startVertex)) return returnVec;
+
+    std::vector<bool> visited(graph.vertexCount(), false);
+    std::stack<int, std::vector<int>> st;
 
     st.push(startVertex);
-    visited.insert(startVertex);
+    visited[startVertex] = true;
 
     while (!st.empty()) {
-        current = st.top();
+        int current = st.top();
         st.pop();
 
         returnVec.push_back(current);
 
-        if (adjacencyMap.find(current) != adjacencyMap.end())
-            for (const auto& adjacent : adjacencyMap.at(current))
-                if (visited.emplace(adjacent).second) {
-                    st.push(adjacent);
-                }
+        for (int i = graph.offsets[current]; i < graph.offsets[current + 1]; ++i) {
+            int adjacent = graph.targets[i];
+            if (!visited[adjacent]) {
+                visited[adjacent] = true;
+                st.push(adjacent);
+            }
+        }
     }
 
     return returnVec;
 }
 
 struct Compare {
-    constexpr bool operator()(const std::pair<int, std::string>& lhs,
-                              const std::pair<int, std::string>& rhs) const {
+    constexpr bool operator()(const std::pair<double, int>& lhs,
+                              const std::pair<double, int>& rhs) const {
         return lhs.first > rhs.first;
     };
 };
 
-std::map<std::string, std::pair<std::map<std::string, int>, std::map<std::string, int>>> Dijkstra(
-    const std::unordered_map<std::string, std::vector<std::pair<int, std::string>>>& adjacencyMap,
-    const std::string& startVertex) {
-    std::priority_queue<std::pair<int, std::string>, std::vector<std::pair<int, std::string>>,
-                        Compare>
-        pq;
-
-    std::map<std::string, int> dist;
+DijkstraResult Dijkstra(const Graph& graph, int startVertex, std::vector<TraversalStep>* steps) {
+    DijkstraResult result;
+    if (!graph.contains(startVertex)) return result;
 
-    std::map<std::string, std::pair<std::map<std::string, int>, std::map<std::string, int>>>
-        returnMap;
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, Compare> pq;
 
-    std::string adjacentVertex;
-    std::string currentVertex;
-    int adjacentVertexWeight;
-
-    for (const auto& entry : adjacencyMap) {
-        dist[entry.first] = std::numeric_limits<int>::max();
-    }
+    std::vector<double>& dist = result.distance;
+    dist.assign(graph.vertexCount(), std::numeric_limits<double>::infinity());
+    result.predecessor.assign(graph.vertexCount(), -1);
 
     dist[startVertex] = 0;
     pq.push({0, startVertex});
 
     while (!pq.empty()) {
-        int dis = pq.top().first;
-        currentVertex = pq.top().second;
+        double dis = pq.top().first;
+        int currentVertex = pq.top().second;
         pq.pop();
 
-        if (adjacencyMap.find(currentVertex) != adjacencyMap.end())
-            for (auto it : adjacencyMap.at(currentVertex)) {
-                adjacentVertexWeight = it.first;
-                adjacentVertex = it.second;
+        if (dis > dist[currentVertex]) continue;
+        if (steps != nullptr) steps->push_back({TraversalStep::Kind::Visit, currentVertex, dis});
+
+        for (int i = graph.offsets[currentVertex]; i < graph.offsets[currentVertex + 1]; ++i) {
+            double adjacentVertexWeight = graph.isWeighted() ? graph.weights[i] : 1;
+            int adjacentVertex = graph.targets[i];
 
-                if (dis + adjacentVertexWeight < dist[adjacentVertex]) {
-                    dist[adjacentVertex] = dis + adjacentVertexWeight;
-                    pq.push({dist[adjacentVertex], adjacentVertex});
-                }
+            if (dis + adjacentVertexWeight < dist[adjacentVertex]) {
+                dist[adjacentVertex] = dis + adjacentVertexWeight;
+                result.predecessor[adjacentVertex] = currentVertex;
+                pq.push({dist[adjacentVertex], adjacentVertex});
 
-                returnMap.insert({currentVertex, {{{adjacentVertex, adjacentVertexWeight}}, dist}});
+                if (steps != nullptr)
+                    steps->push_back(
+                        {TraversalStep::Kind::Relax, adjacentVertex, dist[adjacentVertex]});
             }
+        }
+    }
+
+    return result;
+}
+
+AStarResult AStar(const Graph& graph, const std::vector<Vector2>& positions, int startVertex,
+                  int targetVertex, double distanceUnit, const std::atomic<bool>* cancel) {
+    AStarResult result;
+    if (!graph.contains(startVertex) || !graph.contains(targetVertex)) return result;
+
+    AStarTraversal traversal(graph, positions, startVertex, targetVertex, distanceUnit);
+    std::vector<int> predecessor(graph.vertexCount(), -1);
+    // a relax lowers the distance through the vertex visited last
+    int lastVisit = -1;
+    while (auto step = traversal.next()) {
+        if (step->kind == TraversalStep::Kind::Relax) {
+            predecessor[step->vertex] = lastVisit;
+            continue;
+        }
+
+        lastVisit = step->vertex;
+        ++result.expanded;
+        if (step->vertex == targetVertex) result.distance = step->distance;
+        if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) return result;
     }
-    returnMap.insert({currentVertex, {{{adjacentVertex, adjacentVertexWeight}}, dist}});
 
-    return returnMap;
+    if (result.distance == std::numeric_limits<double>::infinity()) return result;
+    for (int vertex = targetVertex; vertex != -1; vertex = predecessor[vertex])
+        result.path.push_back(vertex);
+    std::reverse(result.path.begin(), result.path.end());
+    return result;
+}
+
+DijkstraExpansionCounter::~DijkstraExpansionCounter() { this->stop(); }
+
+void DijkstraExpansionCounter::start(Graph graph, int startVertex, int targetVertex) {
+    this->stop();
+    this->result = -1;
+    this->worker = std::thread([this, graph = std::move(graph), startVertex, targetVertex] {
+        // without guidance the positions are never looked at
+        std::vector<Vector2> positions(graph.vertexCount());
+        AStarResult counted = AStar(graph, positions, startVertex, targetVertex,
+                                    std::numeric_limits<double>::infinity(), &this->stopping);
+        if (!this->stopping) this->result = counted.expanded;
+    });
+}
+
+void DijkstraExpansionCounter::stop() {
+    this->stopping = true;
+    if (this->worker.joinable()) this->worker.join();
+    this->stopping = false;
+}
+
+double minimumDistanceUnit(const Graph& graph, const std::vector<Vector2>& positions) {
+    double unit = 0;
+    for (int from = 0; from < graph.vertexCount(); ++from) {
+        for (int i = graph.offsets[from]; i < graph.offsets[from + 1]; ++i) {
+            const Vector2& a = positions[from];
+            const Vector2& b = positions[graph.targets[i]];
+            double length = std::hypot(b.x - a.x, b.y - a.y);
+            double weight = graph.isWeighted() ? graph.weights[i] : 1;
+            if (length == 0) continue;
+            if (weight <= 0) return std::numeric_limits<double>::infinity();
+            unit = std::max(unit, length / weight);
+        }
+    }
+    // without any edge of length > 0 the unit doesn't matter
+    return unit > 0 ? unit : 1;
 }
 
 std::optional<Vertex*> tryGetVertex(const std::variant<Vertex*, Edge*>& selection) {
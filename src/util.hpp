@@ -1,36 +1,84 @@
 #ifndef UTIL_HPP
 #define UTIL_HPP
 
-#include <raylib.h>
-
-#include <map>
+#include <atomic>
+#include <limits>
 #include <optional>
-#include <string>
-#include <unordered_map>
+#include <thread>
 #include <variant>
 #include <vector>
 
 #include "edge.hpp"
+#include "graph.hpp"
+#include "traversal.hpp"
+#include "types.hpp"
 #include "vertex.hpp"
 
-enum class Algorithm { BFS, DFS, Dijkstra };
+enum class Algorithm { BFS, DFS, Dijkstra, AStar };
+
+Graph createGraph(const std::vector<Vertex>&, const std::vector<Edge>&);
+
+Graph createGraphWeighted(const std::vector<Vertex>&, const std::vector<Edge>&);
+
+std::vector<int> BFS(const Graph&, int);
+
+std::vector<int> DFS(const Graph&, int);
+
+struct DijkstraResult {
+    // infinity for unreachable vertices
+    std::vector<double> distance;
+    // -1 for the start vertex and unreachable vertices
+    std::vector<int> predecessor;
+};
+
+// the visit/relax log is only recorded when steps is given, DijkstraTraversal produces the
+// same steps lazily
+DijkstraResult Dijkstra(const Graph&, int, std::vector<TraversalStep>* steps = nullptr);
+
+struct AStarResult {
+    // infinity when the target can't be reached
+    double distance = std::numeric_limits<double>::infinity();
+    // start to target, empty when the target can't be reached
+    std::vector<int> path;
+    // vertices taken off the queue, the target included
+    int expanded = 0;
+};
+
+// Shortest path from start to target guided by positions (one per vertex), in the order of
+// AStarTraversal: one unit of weight stands for distanceUnit of straight-line distance. The
+// result is exact as long as no edge weighs less than its own length in units, which holds for
+// every unit from minimumDistanceUnit up; an infinite unit turns the guidance off and leaves
+// Dijkstra stopping at the target. Unweighted graphs weigh 1 per edge. Setting *cancel stops
+// it early, the result is incomplete then.
+AStarResult AStar(const Graph&, const std::vector<Vector2>& positions, int startVertex,
+                  int targetVertex, double distanceUnit,
+                  const std::atomic<bool>* cancel = nullptr);
+
+// Counts the vertices Dijkstra expands for a point-to-point query on a background thread, what
+// A* is compared against, so starting A* doesn't wait for a second full search.
+class DijkstraExpansionCounter {
+   public:
+    DijkstraExpansionCounter() = default;
+    ~DijkstraExpansionCounter();
 
-std::unordered_map<std::string, std::vector<std::string>> createAdjacencyMap(
-    const std::vector<Vertex>&, const std::vector<Edge>&);
+    DijkstraExpansionCounter(const DijkstraExpansionCounter&) = delete;
+    DijkstraExpansionCounter& operator=(const DijkstraExpansionCounter&) = delete;
 
-std::unordered_map<std::string, std::vector<std::pair<int, std::string>>>
-createAdjacencyMapWeighted(const std::vector<Vertex>&, const std::vector<Edge>&);
+    // abandons the count in progress and starts one on this graph
+    void start(Graph graph, int startVertex, int targetVertex);
+    void stop();
 
-std::vector<std::string> BFS(const std::unordered_map<std::string, std::vector<std::string>>&,
-                             const std::string&);
+    // -1 until the count is done
+    inline int expanded() const { return this->result.load(); }
 
-std::vector<std::string> DFS(const std::unordered_map<std::string, std::vector<std::string>>&,
-                             const std::string&);
+   private:
+    std::thread worker;
+    std::atomic<bool> stopping = false;
+    std::atomic<int> result = -1;
+};
 
-// bad, "three star c programmer" equivalent for c++
-std::map<std::string, std::pair<std::map<std::string, int>, std::map<std::string, int>>> Dijkstra(
-    const std::unordered_map<std::string, std::vector<std::pair<int, std::string>>>&,
-    const std::string&);
+// the largest length / weight over all edges, infinity if an edge of length > 0 weighs 0
+double minimumDistanceUnit(const Graph&, const std::vector<Vector2>& positions);
 
 std::optional<Vertex*> tryGetVertex(const std::variant<Vertex*, Edge*>&);
 std::optional<Edge*> tryGetEdge(const std::variant<Vertex*, Edge*>&);
@@ -8,24 +8,22 @@ Vertex::Vertex() {}
 
 Vertex::Vertex(const Vector2& pos, float radius, const Color& color) {
     id = instanceCounter++;
+    this->generation = 0;
     this->pos = pos;
     this->radius = radius;
     this->color = color;
-    this->label = "V" + std::to_string(id);
+    this->label = std::string("V").append(std::to_string(id));
     this->usable = true;
-    this->visualisation_currently_active = false;
-    this->visited = false;
 }
 
 Vertex::Vertex(const Vector2& pos, float radius, const Color& color, const std::string& label) {
     id = instanceCounter++;
+    this->generation = 0;
     this->pos = pos;
     this->radius = radius;
     this->color = color;
     this->label = label;
     this->usable = true;
-    this->visualisation_currently_active = false;
-    this->visited = false;
 }
 
 bool operator==(const Vertex& lhs, const Vertex& rhs) { return lhs.id == rhs.id; }
@@ -1,20 +1,19 @@
 #ifndef VERTEX_HPP
 #define VERTEX_HPP
 
-#include <raylib.h>
-
 #include <string>
 
+#include "types.hpp"
+
 struct Vertex {
     static int instanceCounter;
     int id;
+    unsigned long generation;
     Vector2 pos;
     float radius;
     Color color;
     std::string label;
     bool usable;
-    int visualisation_currently_active;
-    bool visited;
 
     Vertex();
     Vertex(const Vector2& pos, float radius, const Color& color);
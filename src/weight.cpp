@@ -0,0 +1,41 @@
+#include "weight.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+Weight::Weight(std::int64_t value) { this->value = value; }
+
+Weight::Weight(double value) { this->value = value; }
+
+std::optional<Weight> Weight::parse(std::string_view text) {
+    const char* first = text.data();
+    const char* last = text.data() + text.size();
+    if (first == last || text.back() == '.') return std::nullopt;
+
+    std::int64_t integer = 0;
+    auto parsedInteger = std::from_chars(first, last, integer);
+    if (parsedInteger.ec == std::errc() && parsedInteger.ptr == last) return Weight(integer);
+
+    double fraction = 0;
+    auto parsedFraction = std::from_chars(first, last, fraction, std::chars_format::fixed);
+    if (parsedFraction.ec == std::errc() && parsedFraction.ptr == last && std::isfinite(fraction))
+        return Weight(fraction);
+
+    return std::nullopt;
+}
+
+std::string Weight::toString() const {
+    char buffer[32];
+    auto end = std::visit(
+        [&buffer](auto number) { return std::to_chars(buffer, buffer + sizeof(buffer), number).ptr; },
+        this->value);
+    return std::string(buffer, end);
+}
+
+bool operator==(const Weight& lhs, const Weight& rhs) { return lhs.value == rhs.value; }
+bool operator!=(const Weight& lhs, const Weight& rhs) { return lhs.value != rhs.value; }
@@ -0,0 +1,32 @@
+#ifndef WEIGHT_HPP
+#define WEIGHT_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+
+// Numeric edge weight, validated once when it is entered. Integers and fractions are kept apart
+// so integer weights print back exactly as typed; algorithms only ever see asDouble().
+struct Weight {
+    std::variant<std::int64_t, double> value{std::int64_t{0}};
+
+    Weight() = default;
+    Weight(std::int64_t);
+    Weight(double);
+
+    // nullopt for empty, partial ("-", "1.") or non-finite input
+    static std::optional<Weight> parse(std::string_view text);
+
+    std::string toString() const;
+
+    inline double asDouble() const {
+        return std::visit([](auto number) { return static_cast<double>(number); }, this->value);
+    }
+
+    friend bool operator==(const Weight& lhs, const Weight& rhs);
+    friend bool operator!=(const Weight& lhs, const Weight& rhs);
+};
+
+#endif  // WEIGHT_HPP